@@ -0,0 +1,272 @@
+#include "App.hpp"
+#include "CommandLine.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+// Drives App::drawFrame() for a fixed number of frames and reports percentiles as JSON, so changes to the
+// renderer can be compared between commits with numbers instead of by looking at the window.
+//
+// Validation layer output goes to stdout as well, pass --out to get a clean JSON file.
+//
+// Usage: atom_bench [--scene name] [--frames N] [--warmup N] [--headless] [--no-culling] [--lod-threshold px]
+//                   [--vertex-format float|half|snorm16] [--vertex-pulling] [--record-threads N] [--width W] [--height H] [--out file.json]
+//                   [--gpu-passes file.json] [--trace trace.json] [--pipeline-cache file | --no-pipeline-cache]
+
+struct Percentiles {
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    size_t samples = 0;
+};
+
+// Nearest rank percentiles.
+static Percentiles computePercentiles(std::vector<double> values) {
+    Percentiles p;
+    p.samples = values.size();
+
+    if (values.empty()) {
+        return p;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    // Smallest value with at least q of the samples at or below it, the ceil(q * n)-th one
+    auto rank = [&](double q) {
+        size_t r = static_cast<size_t>(std::ceil(q * values.size()));
+        return values[std::min(std::max(r, size_t(1)), values.size()) - 1];
+    };
+
+    p.p50 = rank(0.50);
+    p.p95 = rank(0.95);
+    p.p99 = rank(0.99);
+    p.max = values.back();
+
+    return p;
+}
+
+// Contents of a JSON string literal, names come from the command line and the driver.
+static std::string jsonEscape(const std::string& str) {
+    std::ostringstream out;
+
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+            out << c;
+        }
+    }
+
+    return out.str();
+}
+
+static void writeMetric(std::ostream& out, const char* name, const std::vector<double>& values, bool last = false) {
+    Percentiles p = computePercentiles(values);
+
+    out << "    \"" << jsonEscape(name) << "\": {"
+        << "\"p50\": " << p.p50 << ", "
+        << "\"p95\": " << p.p95 << ", "
+        << "\"p99\": " << p.p99 << ", "
+        << "\"max\": " << p.max << ", "
+        << "\"samples\": " << p.samples << "}" << (last ? "\n" : ",\n");
+}
+
+int main(int argc, char** argv) {
+    AppSettings settings;
+    std::string sceneName = "main";
+    VertexFormat vertexFormat = VertexFormat::Float32;
+    std::string outPath;
+    std::string tracePath;
+    std::string gpuPassesPath;
+    uint32_t frames = 1000;
+    uint32_t warmup = 60;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            settings.headless = true;
+        } else if (strcmp(argv[i], "--no-culling") == 0) {
+            settings.gpuCulling = false;
+        } else if (strcmp(argv[i], "--lod-threshold") == 0 && i + 1 < argc && parseArgument(argv[i + 1], settings.lodThresholdPixels)) {
+            i++;
+        } else if (strcmp(argv[i], "--vertex-format") == 0 && i + 1 < argc && vertexFormatFromName(argv[i + 1], vertexFormat)) {
+            i++;
+        } else if (strcmp(argv[i], "--vertex-pulling") == 0) {
+            settings.vertexPulling = true;
+        } else if (strcmp(argv[i], "--record-threads") == 0 && i + 1 < argc && parseArgument(argv[i + 1], settings.recordThreads)) {
+            i++;
+        } else if (strcmp(argv[i], "--pipeline-cache") == 0 && i + 1 < argc) {
+            settings.pipelineCachePath = argv[++i];
+        } else if (strcmp(argv[i], "--no-pipeline-cache") == 0) {
+            settings.pipelineCachePath.clear();
+        } else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            sceneName = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc && parseArgument(argv[i + 1], frames)) {
+            i++;
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc && parseArgument(argv[i + 1], warmup)) {
+            i++;
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc && parseArgument(argv[i + 1], settings.width)) {
+            i++;
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc && parseArgument(argv[i + 1], settings.height)) {
+            i++;
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--gpu-passes") == 0 && i + 1 < argc) {
+            gpuPassesPath = argv[++i];
+        } else {
+            std::cerr << "Unknown argument or invalid value: " << argv[i] << "\n";
+            std::cerr << "Usage: atom_bench [--scene name] [--frames N] [--warmup N] [--headless] [--no-culling] "
+                         "[--lod-threshold px] [--vertex-format float|half|snorm16] [--vertex-pulling] [--record-threads N] [--width W] [--height H] [--out file.json] [--gpu-passes file.json] [--trace trace.json] [--pipeline-cache file | --no-pipeline-cache]\n";
+            return -1;
+        }
+    }
+
+    // Zones cost next to nothing but aren't free, only record when there's somewhere to write them
+    Trace::setEnabled(!tracePath.empty());
+
+    auto scene = createScene(sceneName);
+
+    if (!scene) {
+        std::cerr << "Unknown scene: " << sceneName << "\n";
+        return -1;
+    }
+
+    scene->vertexFormat = vertexFormat;
+
+    App app;
+    app.setScene(std::move(scene));
+
+    if (!app.init(settings)) {
+        std::cerr << "Failed to initialize Atom3D\n";
+        return -1;
+    }
+
+    std::vector<double> cpu, gpu, wait, acquire, record, submit, present;
+    std::map<std::string, std::vector<double>> gpuPasses;
+
+    cpu.reserve(frames);
+    gpu.reserve(frames);
+    wait.reserve(frames);
+    acquire.reserve(frames);
+    record.reserve(frames);
+    submit.reserve(frames);
+    present.reserve(frames);
+
+    bool ok = true;
+    uint32_t skipped = 0;
+
+    for (uint32_t i = 0; i < warmup + frames; i++) {
+        if (!settings.headless) {
+            glfwPollEvents();
+        }
+
+        if (!app.drawFrame()) {
+            std::cerr << "Failed to draw frame " << i << "\n";
+            ok = false;
+            break;
+        }
+
+        const FrameTimings& t = app.lastFrameTimings();
+
+        // Swapchain got recreated instead, redo the frame. Bounded, a window that stays minimized never renders.
+        if (!t.rendered) {
+            if (++skipped > warmup + frames) {
+                std::cerr << "Too many frames without rendering, stopping\n";
+                ok = false;
+                break;
+            }
+
+            i--;
+            continue;
+        }
+
+        if (i < warmup) {
+            continue;
+        }
+
+        cpu.push_back(t.cpuMs);
+        wait.push_back(t.waitMs);
+        acquire.push_back(t.acquireMs);
+        record.push_back(t.recordMs);
+        submit.push_back(t.submitMs);
+        present.push_back(t.presentMs);
+
+        if (t.gpuMs >= 0.0) {
+            gpu.push_back(t.gpuMs);
+
+            for (auto& scope : app.gpuProfiler().latest()->scopes) {
+                gpuPasses[scope.name].push_back(scope.ms);
+            }
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"scene\": \"" << jsonEscape(sceneName) << "\",\n"
+         << "  \"device\": \"" << jsonEscape(app.deviceName()) << "\",\n"
+         << "  \"headless\": " << (settings.headless ? "true" : "false") << ",\n"
+         << "  \"gpu_culling\": " << (settings.gpuCulling ? "true" : "false") << ",\n"
+         << "  \"lod_threshold\": " << settings.lodThresholdPixels << ",\n"
+         << "  \"vertex_format\": \"" << vertexFormatName(vertexFormat) << "\",\n"
+         << "  \"vertex_pulling\": " << (settings.vertexPulling ? "true" : "false") << ",\n"
+         << "  \"record_threads\": " << app.recordThreads() << ",\n"
+         << "  \"width\": " << settings.width << ",\n"
+         << "  \"height\": " << settings.height << ",\n"
+         << "  \"frames\": " << cpu.size() << ",\n"
+         << "  \"warmup\": " << warmup << ",\n"
+         << "  \"skipped_frames\": " << skipped << ",\n"
+         << "  \"unit\": \"ms\",\n"
+         << "  \"metrics\": {\n";
+
+    writeMetric(json, "cpu_frame", cpu);
+    writeMetric(json, "gpu_frame", gpu);
+    writeMetric(json, "fence_wait", wait);
+    writeMetric(json, "acquire", acquire);
+    writeMetric(json, "record", record);
+    writeMetric(json, "submit", submit);
+    writeMetric(json, "present", present, true);
+
+    json << "  },\n"
+         << "  \"gpu_passes\": {\n";
+
+    for (auto it = gpuPasses.begin(); it != gpuPasses.end(); it++) {
+        writeMetric(json, it->first.c_str(), it->second, std::next(it) == gpuPasses.end());
+    }
+
+    json << "  }\n"
+         << "}\n";
+
+    if (!gpuPassesPath.empty()) {
+        app.gpuProfiler().exportJson(gpuPassesPath);
+    }
+
+    if (!tracePath.empty()) {
+        Trace::dumpChromeJson(tracePath);
+    }
+
+    app.destroy();
+
+    if (outPath.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream file(outPath);
+
+        if (!file.is_open()) {
+            std::cerr << "Failed to open " << outPath << " for writing.\n";
+            return -1;
+        }
+
+        file << json.str();
+    }
+
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,20 @@
+# Turns a SPIR-V binary into a header with its words as a constexpr uint32_t array, run as
+#   cmake -DINPUT=vert.spv -DOUTPUT=vert.spv.h -DSYMBOL=SPIRV_vert -P EmbedSpirv.cmake
+
+file(READ "${INPUT}" hex HEX)
+string(LENGTH "${hex}" hexLength)
+math(EXPR remainder "${hexLength} % 8")
+
+if(hexLength EQUAL 0 OR NOT remainder EQUAL 0)
+    message(FATAL_ERROR "${INPUT} is not SPIR-V, its size is not a multiple of 4 bytes")
+endif()
+
+# SPIR-V is little endian, bytes b0 b1 b2 b3 are the word 0xb3b2b1b0
+string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1," words "${hex}")
+
+get_filename_component(inputName "${INPUT}" NAME)
+
+file(WRITE "${OUTPUT}"
+    "// Generated from ${inputName} by cmake/EmbedSpirv.cmake, do not edit\n"
+    "#include <cstdint>\n\n"
+    "constexpr uint32_t ${SYMBOL}[] = {${words}};\n")
@@ -8,14 +8,18 @@ struct AllocatedBuffer {
     vk::Buffer buffer;
     vma::Allocation allocation;
 
-    static AllocatedBuffer createBuffer(vma::Allocator& allocator, size_t size, vk::BufferUsageFlags usage, vma::MemoryUsage memUsage) {
+    // Defaults to a persistently mapped, host writable allocation. Pass empty flags for buffers only the GPU touches,
+    // which lets VMA pick plain device local memory.
+    static AllocatedBuffer createBuffer(vma::Allocator& allocator, size_t size, vk::BufferUsageFlags usage, vma::MemoryUsage memUsage,
+                                        vma::AllocationCreateFlags flags = vma::AllocationCreateFlagBits::eMapped |
+                                                                           vma::AllocationCreateFlagBits::eHostAccessSequentialWrite) {
         vk::BufferCreateInfo buffInfo;
         buffInfo.setSize(size)
             .setUsage(usage);
 
         vma::AllocationCreateInfo vmaAllocInfo;
         vmaAllocInfo.setUsage(memUsage)
-            .setFlags(vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessSequentialWrite);
+            .setFlags(flags);
 
         AllocatedBuffer newBuff;
 
@@ -26,28 +30,6 @@ struct AllocatedBuffer {
 
         return newBuff;
     }
-
-    static void copyBuffer(vk::Buffer src, vk::Buffer dst, vk::DeviceSize size, vk::CommandBuffer commandBuffer, vk::Queue subQueue) {
-        commandBuffer.reset();
-
-        vk::CommandBufferBeginInfo info(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-
-        // Record
-        commandBuffer.begin(info);
-
-        vk::BufferCopy region;
-        region.setSize(size);
-        commandBuffer.copyBuffer(src, dst, region);
-
-        commandBuffer.end();
-
-        // Submit
-        vk::SubmitInfo subInfo;
-        subInfo.setCommandBuffers(commandBuffer);
-
-        subQueue.submit(subInfo, nullptr);
-        subQueue.waitIdle();
-    }
 };
 
 #endif
\ No newline at end of file
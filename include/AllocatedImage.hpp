@@ -0,0 +1,56 @@
+#ifndef ALLOCATED_IMAGE_HPP
+#define ALLOCATED_IMAGE_HPP
+
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan.hpp>
+
+struct AllocatedImage {
+    vk::Image image;
+    vk::ImageView view;
+    vma::Allocation allocation;
+
+    static AllocatedImage createImage(vma::Allocator& allocator, vk::Device device, vk::Extent2D extent, vk::Format format, vk::ImageUsageFlags usage) {
+        vk::ImageCreateInfo imageInfo;
+        imageInfo.setImageType(vk::ImageType::e2D)
+            .setFormat(format)
+            .setExtent(vk::Extent3D(extent, 1))
+            .setMipLevels(1)
+            .setArrayLayers(1)
+            .setSamples(vk::SampleCountFlagBits::e1)
+            .setTiling(vk::ImageTiling::eOptimal)
+            .setUsage(usage)
+            .setSharingMode(vk::SharingMode::eExclusive)
+            .setInitialLayout(vk::ImageLayout::eUndefined);
+
+        vma::AllocationCreateInfo vmaAllocInfo;
+        vmaAllocInfo.setUsage(vma::MemoryUsage::eAutoPreferDevice);
+
+        AllocatedImage newImage;
+
+        auto [i, a] = allocator.createImage(imageInfo, vmaAllocInfo);
+
+        newImage.image = i;
+        newImage.allocation = a;
+
+        vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+        vk::ImageViewCreateInfo viewInfo;
+        viewInfo.setImage(newImage.image)
+            .setViewType(vk::ImageViewType::e2D)
+            .setFormat(format)
+            .setSubresourceRange(range);
+
+        newImage.view = device.createImageView(viewInfo);
+
+        return newImage;
+    }
+
+    static void destroyImage(vma::Allocator& allocator, vk::Device device, AllocatedImage& image) {
+        device.destroyImageView(image.view);
+        allocator.destroyImage(image.image, image.allocation);
+
+        image = {};
+    }
+};
+
+#endif
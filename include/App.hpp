@@ -8,22 +8,36 @@
 // VULKAN
 #include <VkBootstrap.h>
 
-#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+// VULKAN_HPP_DISPATCH_LOADER_DYNAMIC is set for every target by CMake, storage lives in VulkanStorage.cpp
 #include <vulkan/vulkan.hpp>
 
-VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
-
 // STD
+#include <array>
 #include <deque>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "AllocatedBuffer.hpp"
+#include "AllocatedImage.hpp"
+#include "Bindless.hpp"
+#include "FrameAllocator.hpp"
+#include "GpuCulling.hpp"
+#include "GpuProfiler.hpp"
 #include "Mesh.hpp"
+#include "ParallelRecorder.hpp"
+#include "PipelineCache.hpp"
+#include "PipelineCompiler.hpp"
+#include "PipelineStateCache.hpp"
 #include "Scene.hpp"
+#include "ShaderLibrary.hpp"
+#include "ShaderWatcher.hpp"
+#include "TimelineSemaphore.hpp"
+#include "TransferQueue.hpp"
 #include "Vertex.hpp"
 
 constexpr int MAX_FRAMES_IN_FLIGHT = 3;
@@ -38,36 +52,98 @@ constexpr int MAX_FRAMES_IN_FLIGHT = 3;
 #define ATOM3D_VK_VERSION VK_MAKE_API_VERSION(0, 1, 4, 303)
 #endif
 
+// Destruction deferred until the GPU is done with the frame that last used an object, frames being values of the
+// frame timeline.
 struct DeletionQueue {
-    std::deque<vk::Buffer> buffers;
-    std::deque<vk::Image> images;
-    std::deque<vk::Image> imageViews;
-    std::deque<std::function<void()>> functions;
+    struct Entry {
+        uint64_t frame;
+        std::function<void()> destroy;
+    };
 
-    void flush() {
-        auto bit = buffers.rbegin();
-        auto iit = images.rbegin();
-        auto ivit = imageViews.rbegin();
-        auto fit = functions.rbegin();
-
-        while (buffers.size() != 0 && images.size() != 0 && imageViews.size() != 0 && functions.size() != 0) {
-            if (bit != buffers.rend()) bit++;
-            if (iit != images.rend()) iit++;
-            if (ivit != imageViews.rend()) ivit++;
-            if (fit != functions.rend()) fit++;
+    std::deque<Entry> entries;  // Frames never decrease, oldest first
+
+    void push(uint64_t frame, std::function<void()> destroy) {
+        entries.push_back({frame, std::move(destroy)});
+    }
+
+    // Runs everything belonging to a frame at or before completedFrame.
+    void collect(uint64_t completedFrame) {
+        while (!entries.empty() && entries.front().frame <= completedFrame) {
+            entries.front().destroy();
+            entries.pop_front();
         }
     }
+
+    // Everything, only once the device is idle.
+    void flush() {
+        collect(UINT64_MAX);
+    }
+};
+
+struct AppSettings {
+    // Headless skips GLFW and the swapchain entirely and renders into VMA owned offscreen images instead.
+    // Needed for CI and render nodes without a display (works on software ICDs such as lavapipe).
+    bool headless = false;
+
+    uint32_t width = 800;
+    uint32_t height = 600;
+
+    // Frustum culling in the compute pass ahead of the graphics pass. Off keeps every instance.
+    bool gpuCulling = true;
+
+    // Largest on screen error a mesh LOD may have, in pixels. 0 always draws the full mesh.
+    float lodThresholdPixels = 1.f;
+
+    // Fetch vertices and instances in the vertex shader through buffer device addresses (shader_pull.vert) instead
+    // of vertex input state. The shader is specialized for the vertex format then.
+    bool vertexPulling = false;
+
+    // Pipeline cache file, loaded on init() and written back on destroy(). Empty compiles from scratch every run.
+    std::string pipelineCachePath = "atom3d_pipeline_cache.bin";
+
+    // Directory of loose .spv files (make shaders) used instead of the embedded ones. Empty uses the embedded
+    // shaders only.
+    std::string shaderDir;
+
+    // Rebuild pipelines in the background whenever their SPIR-V in shaderDir changes, windowed only.
+    bool shaderHotReload = true;
+
+    // Threads recording the scene pass into secondary command buffers, one draw chunk each. 0 is one per core,
+    // 1 records it straight into the frame's command buffer.
+    uint32_t recordThreads = 0;
+};
+
+// Where the time of the last drawFrame() went, all in milliseconds.
+struct FrameTimings {
+    double cpuMs = 0.0;      // Whole drawFrame() call
+    double waitMs = 0.0;     // Waiting for the frame in flight slot to come free
+    double acquireMs = 0.0;  // acquireNextImageKHR
+    double recordMs = 0.0;   // Command buffer recording
+    double submitMs = 0.0;   // Queue submit
+    double presentMs = 0.0;  // presentKHR
+
+    // GPU time of the frame that last used this frame in flight slot (MAX_FRAMES_IN_FLIGHT frames ago),
+    // per pass numbers for the same frame are in App::gpuProfiler().latest().
+    // Negative when there's nothing to report yet or timestamps aren't supported.
+    double gpuMs = -1.0;
+
+    // False if drawFrame() returned without submitting anything (swapchain out of date and recreated instead), the
+    // numbers above aren't a frame then.
+    bool rendered = false;
 };
 
 class App {
 public:
-    bool init();
+    bool init(const AppSettings& settings = {});
 
     bool createSwapchain();
     bool createSwapchainImageViews();
     bool recreateSwapchain();
     void cleanupSwapchain();
 
+    bool createOffscreenTargets();
+    void destroyOffscreenTargets();
+
     bool getQueues();
 
     void createRenderPass();
@@ -77,9 +153,27 @@ public:
     void dynamicRenderingStuff();
 #endif
 
-    std::vector<char> loadSPV(const std::string& filename);
+    // What the scene pipeline depends on besides its shaders. Swapchain recreation and scene changes rewrite the
+    // members, so it's copied on the main thread for the compiler threads.
+    struct ScenePipelineState {
+        VertexFormat vertexFormat;
+        vk::Format colorFormat;
+        vk::RenderPass renderPass;
+    };
+
     vk::ShaderModule createShaderModule(const std::vector<char>& code);
-    bool createGraphicsPipeline();
+    void createGraphicsPipelineLayout();
+    std::future<vk::Pipeline> queueScenePipeline(CompilePriority priority);
+    std::future<vk::Pipeline> queueCullingPipeline(CompilePriority priority);
+    GraphicsPipelineDesc scenePipelineDesc(const ScenePipelineState& state, const std::vector<char>& vertCode,
+                                           const std::vector<char>& fragCode) const;
+    std::string sceneVertexShader() const;
+    bool createCullingPass(vk::Pipeline pipeline);
+
+    // Once per frame before recording: swaps in pipelines whose rebuild finished and starts rebuilds for shaders
+    // that changed.
+    void updateShaderReload();
+    void retirePipeline(vk::Pipeline pipeline);
 
     bool createFramebuffers();
 
@@ -90,17 +184,41 @@ public:
     void destroySyncObjects();
 
     void recordDrawCommandsScene(vk::CommandBuffer, uint32_t, Scene*);
+    void recordSceneChunk(vk::CommandBuffer cb, const Scene& scene, uint32_t chunk, const std::array<uint32_t, 2>& dynamicOffsets) const;
+    void submitAndWait(vk::CommandBuffer cb);
     bool drawFrame();
     void windowLoop();
+    bool runHeadless(uint32_t frameCount);
+
+    bool saveFrame(const std::string& path);
 
     void destroy();
 
     void setupScene();
+    void setScene(std::unique_ptr<Scene> scene);
+
+    const FrameTimings& lastFrameTimings() const { return m_frameTimings; }
+    const GpuProfiler& gpuProfiler() const { return m_gpuProfiler; }
+    std::string deviceName() const { return m_vkbPD.name; }
+    uint32_t recordThreads() const { return m_recorder.threadCount(); }
+
+    // Every graphics submission (drawFrame(), readbacks) signals the next frame timeline value. Anything recorded
+    // for value N can be reused, destroyed or read back once isFrameDone(N).
+    const TimelineSemaphore& frameTimeline() const { return m_frameTimeline; }
+    uint64_t lastSubmittedFrame() const { return m_frameTimeline.lastSignaled(); }
+    bool isFrameDone(uint64_t frame) const { return m_frameTimeline.isDone(frame); }
+
+    // Global descriptor set, bound to set 1 of the scene pass. Register textures, samplers and buffers here and hand
+    // the slots to shaders (materials, push constants).
+    BindlessDescriptors& bindless() { return m_bindless; }
+
+    // Runs destroy once every frame submitted so far has finished.
+    void deferDeletion(std::function<void()> destroy) { m_delQueue.push(m_frameTimeline.lastSignaled(), std::move(destroy)); }
 
     AllocatedBuffer& createBuffer(size_t size, vk::BufferUsageFlags usage, vma::MemoryUsage memUsage);
 
 public:
-    bool glfwFramebufferResized;
+    bool glfwFramebufferResized = false;
 
 private:
     // Vulkan Handles
@@ -110,7 +228,7 @@ private:
     vk::SurfaceKHR m_surface;
     vk::Queue m_graphicsQueue, m_presentQueue;
     vk::RenderPass m_renderPass;
-    vk::PipelineLayout m_pipelineLayout;
+    vk::PipelineLayout m_pipelineLayout;  // Both owned by m_pipelines
     vk::Pipeline m_graphicsPipeline;
     vk::CommandPool m_commandPool;
     vk::SwapchainKHR m_swapchain;
@@ -120,14 +238,23 @@ private:
     std::vector<VkImage> m_swapchainImages;
     std::vector<VkImageView> m_swapchainImageViews;
 
+    // Render target description, shared by the swapchain and the headless path.
+    vk::Extent2D m_renderExtent;
+    vk::Format m_colorFormat = vk::Format::eUndefined;
+    vk::ImageLayout m_colorFinalLayout = vk::ImageLayout::ePresentSrcKHR;
+
+    // Headless only, stand in for the swapchain images.
+    std::vector<AllocatedImage> m_offscreenImages;
+
     // Sync
     std::vector<vk::Semaphore> m_imageAvailableSems;
     std::vector<vk::Semaphore> m_renderFinishedSems;
-    std::vector<vk::Fence> m_inFlightFences;
-    std::vector<vk::Fence> m_imageInFlightFences;
+    TimelineSemaphore m_frameTimeline;                               // Signaled with the frame number by every frame
+    std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> m_frameSlotValues{};  // Last frame that used each frame in flight slot
+    std::vector<uint64_t> m_commandBufferValues;                     // Last frame that used each of m_commandBuffers
 
     // GLFW Handles
-    GLFWwindow* m_glfwWindow;
+    GLFWwindow* m_glfwWindow = nullptr;
 
     // VKB Handles
     vkb::Instance m_vkbInstance;
@@ -141,9 +268,31 @@ private:
 
     // Atom Shtuff
     DeletionQueue m_delQueue;
-    MainScene m_scene;
+    TransferQueue m_transfer;
+    FrameAllocator m_frameAllocator;
+    BindlessDescriptors m_bindless;
+    PipelineCache m_pipelineCache;
+    PipelineStateCache m_pipelines;
+    ShaderLibrary m_shaders;
+
+    // Shader hot reload, rebuilds run on m_compiler and hand back VK_NULL_HANDLE on failure.
+    ShaderWatcher m_shaderWatcher;
+    std::future<vk::Pipeline> m_graphicsReload;
+    std::future<vk::Pipeline> m_cullingReload;
+    bool m_graphicsShadersChanged = false;
+    bool m_cullShaderChanged = false;
+    ScenePushConstants m_scenePush;  // Filled in by setupScene()
+    std::unique_ptr<Scene> m_scene;
+
+    // Frame timing
+    FrameTimings m_frameTimings;
+    GpuProfiler m_gpuProfiler;
+    GpuCulling m_culling;
+
+    AppSettings m_settings;
 
     int m_currentFrame = 0;
+    uint32_t m_lastImageIndex = 0;
 
     // Other Vulkan Things
     const VkDebugUtilsMessageSeverityFlagsEXT debug_severity =
@@ -156,6 +305,10 @@ private:
         VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
         VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT |
         VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+
+    // Last, so their jobs finish before any of the above goes away
+    PipelineCompiler m_compiler;
+    ParallelRecorder m_recorder;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef BINDLESS_HPP
+#define BINDLESS_HPP
+
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <vector>
+
+#include "AllocatedImage.hpp"
+#include "PipelineStateCache.hpp"
+
+// Upper bounds of the bindless arrays, clamped to the device's update after bind limits on init.
+constexpr uint32_t BINDLESS_MAX_IMAGES = 16384;
+constexpr uint32_t BINDLESS_MAX_SAMPLERS = 256;
+constexpr uint32_t BINDLESS_MAX_STORAGE_BUFFERS = 4096;
+
+constexpr uint32_t BINDLESS_BINDING_IMAGES = 0;
+constexpr uint32_t BINDLESS_BINDING_SAMPLERS = 1;
+constexpr uint32_t BINDLESS_BINDING_STORAGE_BUFFERS = 2;
+
+// Slot 0 of the image and sampler arrays, what materials point at unless told otherwise.
+constexpr uint32_t BINDLESS_DEFAULT_IMAGE = 0;
+constexpr uint32_t BINDLESS_DEFAULT_SAMPLER = 0;
+
+// What add*() returns once an array is full.
+constexpr uint32_t BINDLESS_INVALID_SLOT = UINT32_MAX;
+
+// One global descriptor set with every sampled image, sampler and storage buffer the renderer uses, in big
+// partially bound arrays (descriptor indexing). It's bound once per frame, shaders pick resources by index (a
+// material's texture, a buffer handed over in a push constant) instead of the CPU binding them per draw.
+//
+//   binding 0, sampled image[], shaders combine them with one of the samplers
+//   binding 1, sampler[]
+//   binding 2, storage buffer[]
+//
+// Every binding is update after bind: add*() writes its slot right away, even while earlier frames that have the
+// set bound are still in flight, as long as they don't read that slot. Which is also why free*() must wait until
+// no frame in flight can still use the slot (App::deferDeletion()).
+class BindlessDescriptors {
+public:
+    // The set layout comes from (and stays owned by) pipelines.
+    bool init(vk::Device device, vk::PhysicalDevice physicalDevice, PipelineStateCache& pipelines, vma::Allocator allocator);
+    void destroy();
+
+    // Clears the default image to white and moves it to ShaderReadOnlyOptimal. cb has to be on the graphics queue
+    // and done before the first frame samples it.
+    void recordDefaults(vk::CommandBuffer cb);
+
+    // Return the slot to index the matching array with, or BINDLESS_INVALID_SLOT if the array is full.
+    uint32_t addImage(vk::ImageView view, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+    uint32_t addSampler(vk::Sampler sampler);
+    uint32_t addStorageBuffer(vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+
+    void freeImage(uint32_t slot) { m_images.free(slot); }
+    void freeSampler(uint32_t slot) { m_samplers.free(slot); }
+    void freeStorageBuffer(uint32_t slot) { m_storageBuffers.free(slot); }
+
+    vk::DescriptorSetLayout setLayout() const { return m_setLayout; }
+    vk::DescriptorSet descriptorSet() const { return m_descriptorSet; }
+
+private:
+    // Hands out the slots of one array, freed slots get reused before the array grows.
+    struct SlotAllocator {
+        uint32_t capacity = 0;
+        uint32_t next = 0;
+        std::vector<uint32_t> freed;
+
+        uint32_t allocate();
+        void free(uint32_t slot) { freed.push_back(slot); }
+    };
+
+    vk::Device m_device;
+    vma::Allocator m_allocator;
+
+    vk::DescriptorSetLayout m_setLayout;
+    vk::DescriptorPool m_descriptorPool;
+    vk::DescriptorSet m_descriptorSet;
+
+    SlotAllocator m_images;
+    SlotAllocator m_samplers;
+    SlotAllocator m_storageBuffers;
+
+    AllocatedImage m_defaultImage;
+    vk::Sampler m_defaultSampler;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef COMMAND_LINE_HPP
+#define COMMAND_LINE_HPP
+
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+#include <type_traits>
+
+// Parses a whole command line value (uint32_t, float, ...). Anything else, trailing characters or a value out of
+// range included, returns false and leaves value alone, so the caller can print its usage instead of throwing.
+template <typename T>
+bool parseArgument(const char* arg, T& value) {
+    const char* end = arg + strlen(arg);
+
+    T parsed;
+
+    if constexpr (std::is_floating_point_v<T>) {
+        // Floating point from_chars is missing from older libc++ (Apple clang), strtof/strtod are everywhere.
+        // They skip leading whitespace, from_chars doesn't.
+        if (arg == end || std::isspace(static_cast<unsigned char>(*arg))) {
+            return false;
+        }
+
+        char* ptr = nullptr;
+        errno = 0;
+
+        if constexpr (std::is_same_v<T, float>) {
+            parsed = std::strtof(arg, &ptr);
+        } else {
+            parsed = static_cast<T>(std::strtod(arg, &ptr));
+        }
+
+        if (errno == ERANGE || ptr != end) {
+            return false;
+        }
+    } else {
+        auto [ptr, ec] = std::from_chars(arg, end, parsed);
+
+        if (ec != std::errc() || ptr == arg || ptr != end) {
+            return false;
+        }
+    }
+
+    value = parsed;
+
+    return true;
+}
+
+#endif
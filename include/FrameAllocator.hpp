@@ -0,0 +1,89 @@
+#ifndef FRAME_ALLOCATOR_HPP
+#define FRAME_ALLOCATOR_HPP
+
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <cstring>
+#include <optional>
+
+#include "AllocatedBuffer.hpp"
+#include "PipelineStateCache.hpp"
+
+constexpr vk::DeviceSize FRAME_ALLOCATOR_SIZE = 4ull << 20;  // Per frame in flight
+constexpr vk::DeviceSize FRAME_UNIFORM_RANGE = 16 * 1024;    // Guaranteed minimum of maxUniformBufferRange
+constexpr vk::DeviceSize FRAME_STORAGE_RANGE = 1ull << 20;
+
+// Scratch memory for uniform and storage data that only lives for one frame (camera, per object constants, ...).
+//
+// One persistently mapped buffer, split into a region per frame in flight. beginFrame() rewinds the slot's region
+// (the caller has waited on the frame that last used it) and every allocation is a pointer bump. Nothing is bound
+// per allocation: the descriptor set has one dynamic uniform and one dynamic storage binding over the whole buffer,
+// allocations hand back the dynamic offset to bind it with.
+//
+//   binding 0, uniform buffer dynamic, FRAME_UNIFORM_RANGE bytes
+//   binding 1, storage buffer dynamic, FRAME_STORAGE_RANGE bytes
+class FrameAllocator {
+public:
+    struct Allocation {
+        void* data = nullptr;  // nullptr if the frame's region is full
+        uint32_t offset = 0;   // Dynamic offset
+    };
+
+    // The set layout comes from (and stays owned by) pipelines.
+    bool init(vk::Device device, PipelineStateCache& pipelines, vma::Allocator allocator, const vk::PhysicalDeviceLimits& limits,
+              uint32_t framesInFlight);
+    void destroy();
+
+    void beginFrame(uint32_t frameSlot);
+
+    // Makes the frame's writes visible to the device, no-op on coherent memory. Before submitting.
+    void flush();
+
+    Allocation allocateUniform(vk::DeviceSize size) { return allocate(size, m_uniformAlignment); }
+    Allocation allocateStorage(vk::DeviceSize size) { return allocate(size, m_storageAlignment); }
+
+    // Copies value into a fresh uniform allocation, returns its dynamic offset. Empty if the frame's region is full,
+    // offset 0 would read whatever another frame put there.
+    template <typename T>
+    std::optional<uint32_t> pushUniform(const T& value) {
+        static_assert(sizeof(T) <= FRAME_UNIFORM_RANGE, "Larger than the uniform binding's range");
+
+        Allocation a = allocateUniform(sizeof(T));
+
+        if (!a.data) {
+            return std::nullopt;
+        }
+
+        memcpy(a.data, &value, sizeof(T));
+
+        return a.offset;
+    }
+
+    vk::DescriptorSetLayout setLayout() const { return m_setLayout; }
+    vk::DescriptorSet descriptorSet() const { return m_descriptorSet; }
+
+    vk::DeviceSize used() const { return m_head - m_frameStart; }
+
+private:
+    Allocation allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+
+    vk::Device m_device;
+    vma::Allocator m_allocator;
+
+    AllocatedBuffer m_buffer;
+    uint8_t* m_mapped = nullptr;
+
+    vk::DeviceSize m_uniformAlignment = 256;
+    vk::DeviceSize m_storageAlignment = 256;
+
+    vk::DeviceSize m_frameStart = 0;
+    vk::DeviceSize m_head = 0;
+    bool m_overflowReported = false;
+
+    vk::DescriptorSetLayout m_setLayout;
+    vk::DescriptorPool m_descriptorPool;
+    vk::DescriptorSet m_descriptorSet;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef GPU_CULLING_HPP
+#define GPU_CULLING_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include "PipelineStateCache.hpp"
+#include "Scene.hpp"
+
+// Push constant block of cull.comp
+struct CullPushConstants {
+    glm::vec4 planes[6];
+    glm::vec4 wRow;
+    uint32_t instanceCount;
+    uint32_t batchCount;
+    uint32_t flags;
+    float lodFactor;
+};
+
+static_assert(sizeof(CullPushConstants) <= 128, "Push constants past the guaranteed minimum");
+
+constexpr uint32_t CULL_FLAG_CULLING = 1 << 0;
+constexpr uint32_t CULL_FLAG_LOD = 1 << 1;
+constexpr uint32_t CULL_FLAG_PHASE_DRAWS = 1 << 2;
+constexpr uint32_t CULL_FLAG_PHASE_INSTANCES = 1 << 3;
+
+// Compute pass run before the graphics pass. Tests every scene instance against the camera frustum, picks a LOD from
+// its projected error, compacts the survivors into the per instance vertex stream and emits one instanced draw per
+// non empty (batch, LOD) into the scene's indirect buffer + count buffer, per draw chunk, see cull.comp.
+class GpuCulling {
+public:
+    // pipeline is one compiled from pipelineDesc(). Layouts and the pipeline stay owned by pipelines. A scene without
+    // geometry (maxDrawCount 0) gets no descriptors, don't record() for it.
+    bool init(vk::Device device, PipelineStateCache& pipelines, const Scene& scene, vk::Pipeline pipeline);
+    void destroy();
+
+    // Description of the culling pipeline for cull.comp's SPIR-V. Only needs the cache for the layouts, so the
+    // pipeline can be compiled before init() and rebuilt from another thread (hot reload).
+    static ComputePipelineDesc pipelineDesc(PipelineStateCache& pipelines, const std::vector<char>& cullCode);
+
+    vk::Pipeline pipeline() const { return m_pipeline; }
+
+    // Uses pipeline from the next record() on, returns the previous one for the caller to retire (hot reload).
+    vk::Pipeline swapPipeline(vk::Pipeline pipeline) {
+        vk::Pipeline old = m_pipeline;
+        m_pipeline = pipeline;
+        return old;
+    }
+
+    // Must be recorded outside of a render pass, leaves the outputs ready for drawIndexedIndirectCount.
+    // viewportHeight converts the LOD threshold from pixels to clip space.
+    void record(vk::CommandBuffer cb, const Scene& scene, uint32_t viewportHeight);
+
+    // Off still runs the pass (so the draw path stays the same) but keeps every instance.
+    void setFrustumCulling(bool enabled) { m_frustumCulling = enabled; }
+
+    // Largest allowed on screen LOD error in pixels, 0 or less always draws LOD 0.
+    void setLodThreshold(float pixels) { m_lodThresholdPixels = pixels; }
+
+    // Gribb/Hartmann plane extraction for a [0, 1] depth range, normalized.
+    static void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+private:
+    static DescriptorSetLayoutDesc setLayoutDesc();
+    static PipelineLayoutDesc pipelineLayoutDesc(PipelineStateCache& pipelines);
+
+    vk::Device m_device;
+    vk::DescriptorSetLayout m_setLayout;
+    vk::DescriptorPool m_descriptorPool;
+    vk::DescriptorSet m_descriptorSet;
+    vk::PipelineLayout m_pipelineLayout;
+    vk::Pipeline m_pipeline;
+
+    bool m_frustumCulling = true;
+    float m_lodThresholdPixels = 1.f;
+};
+
+#endif
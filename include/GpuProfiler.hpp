@@ -0,0 +1,74 @@
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#include <VkBootstrap.h>
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+constexpr uint32_t GPU_PROFILER_MAX_SCOPES = 32;   // Per frame, every scope takes two timestamps
+constexpr uint32_t GPU_PROFILER_HISTORY = 256;     // Frames kept around for querying/exporting
+
+struct GpuScopeResult {
+    std::string name;
+    double ms;
+};
+
+struct GpuFrameResult {
+    uint64_t frame;
+    std::vector<GpuScopeResult> scopes;
+
+    // Negative if the frame has no scope with that name.
+    double durationMs(const std::string& name) const {
+        for (auto& s : scopes) {
+            if (s.name == name) return s.ms;
+        }
+
+        return -1.0;
+    }
+};
+
+// Timestamp queries around render passes. Every frame in flight owns its own query pool, results are read back
+// the next time that slot comes around (MAX_FRAMES_IN_FLIGHT frames later), after its fence was waited on, so
+// collecting them never stalls.
+class GpuProfiler {
+public:
+    bool init(vk::Device device, const vkb::PhysicalDevice& physDevice, uint32_t queueFamily, uint32_t framesInFlight);
+    void destroy();
+
+    bool enabled() const { return !m_pools.empty(); }
+
+    // Must be recorded before any scope and outside of a render pass. Returns true if the results of the previous
+    // frame that used this slot were collected, they're then available through latest().
+    bool beginFrame(vk::CommandBuffer cb, uint32_t frameSlot);
+
+    // Returns a handle for endScope(), scopes past GPU_PROFILER_MAX_SCOPES are silently dropped.
+    // name is kept until the results come back, so it has to be a string literal or otherwise outlive the frame.
+    uint32_t beginScope(vk::CommandBuffer cb, const char* name);
+    void endScope(vk::CommandBuffer cb, uint32_t scope);
+
+    const std::deque<GpuFrameResult>& history() const { return m_history; }
+    const GpuFrameResult* latest() const { return m_history.empty() ? nullptr : &m_history.back(); }
+
+    bool exportJson(const std::string& path) const;
+
+private:
+    struct FrameSlot {
+        std::vector<const char*> names;
+        uint64_t frame = 0;
+    };
+
+    vk::Device m_device;
+    std::vector<vk::QueryPool> m_pools;
+    std::vector<FrameSlot> m_slots;
+    std::deque<GpuFrameResult> m_history;
+
+    uint32_t m_currentSlot = 0;
+    uint64_t m_frameCounter = 0;
+    double m_timestampPeriodNs = 0.0;
+    uint64_t m_timestampMask = ~0ull;
+};
+
+#endif
@@ -4,14 +4,44 @@
 #include "AllocatedBuffer.hpp"
 #include "Vertex.hpp"
 
-struct MvpUbo {
-    glm::mat4 model;
-    glm::mat4 view;
-    glm::mat4 projection;
+// LOD 0 is the mesh itself, the rest come from generateLods(). Keep in sync with cull.comp.
+constexpr uint32_t MAX_MESH_LODS = 4;
+
+// Simplified version of a mesh, indexes into the same vertices as LOD 0.
+struct MeshLod {
+    std::vector<uint32_t> indices;
+    float error = 0.f;  // Object space deviation from LOD 0
+};
+
+// Mesh space position = quantized position * scale + offset
+struct VertexDequant {
+    glm::vec3 scale = glm::vec3(1.f);
+    glm::vec3 offset = glm::vec3(0.f);
 };
 
 struct Mesh {
     std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;  // LOD 1 and up, coarser with every entry
+
+    // 16 bit indices whenever the vertex count allows it, halves index memory and fetch bandwidth.
+    vk::IndexType indexType() const {
+        return vertices.size() <= 0x10000 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+    }
+
+    // Merges identical vertices and rewrites the indices (LODs included) to match. Meshes without indices are
+    // treated as a triangle list soup. Scene::uploadMeshes welds every mesh, importers can hand over soups.
+    void weldVertices();
+
+    // Fills lods with up to MAX_MESH_LODS - 1 quadric simplified versions, each about half of the previous.
+    // Stops early once simplification doesn't get anywhere (locked borders/seams, tiny meshes).
+    void generateLods();
+
+    // Appends the vertices as PackedVertex (format must not be Float32), positions normalized to the bounding box.
+    VertexDequant quantize(VertexFormat format, std::vector<PackedVertex>& out) const;
+
+    // xyz center, w radius. Centered on the bounding box, not minimal but cheap and good enough for culling.
+    glm::vec4 boundingSphere() const;
 
     static void triangle(Mesh& mesh) {
         mesh.vertices.resize(3);
@@ -24,7 +54,26 @@ struct Mesh {
         mesh.vertices[0].color = {1.f, 0.f, 0.0f};
         mesh.vertices[1].color = {0.f, 1.f, 0.0f};
         mesh.vertices[2].color = {0.f, 0.f, 1.0f};
+
+        mesh.indices = {0, 1, 2};
+    }
+
+    // UV sphere of radius 1, clockwise seen from outside like the rest of the scene geometry (front faces are
+    // clockwise on screen, see App::scenePipelineDesc()).
+    static void sphere(Mesh& mesh, uint32_t rings, uint32_t segments);
+
+    // Two triangles sharing an edge, built as a soup and welded down to 4 vertices.
+    static void quad(Mesh& mesh) {
+        Vertex tl{{-1.f, -1.f, 0.f}, {1.f, 1.f, 1.f}, {0.f, 0.f}};
+        Vertex tr{{1.f, -1.f, 0.f}, {1.f, 1.f, 1.f}, {1.f, 0.f}};
+        Vertex bl{{-1.f, 1.f, 0.f}, {1.f, 1.f, 1.f}, {0.f, 1.f}};
+        Vertex br{{1.f, 1.f, 0.f}, {1.f, 1.f, 1.f}, {1.f, 1.f}};
+
+        mesh.vertices = {tl, tr, br, tl, br, bl};
+        mesh.indices.clear();
+
+        mesh.weldVertices();
     }
 };
 
-#endif
\ No newline at end of file
+#endif
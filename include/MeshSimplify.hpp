@@ -0,0 +1,22 @@
+#ifndef MESH_SIMPLIFY_HPP
+#define MESH_SIMPLIFY_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "Vertex.hpp"
+
+/// @brief Quadric error metric simplification (Garland/Heckbert) by half edge collapse. Vertices only ever collapse
+/// onto existing ones, so the result indexes into the same vertex array and LODs can share one vertex range.
+/// Border and attribute seam vertices are locked to keep the silhouette and avoid cracks.
+/// @param vertices
+/// @param indices Triangle list
+/// @param targetIndexCount Stops once the triangle count is at or below this (or nothing can be collapsed anymore)
+/// @param outError Largest collapse error, roughly a distance in mesh units. Optional.
+/// @return Simplified triangle list
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices,
+                                   const std::vector<uint32_t>& indices,
+                                   size_t targetIndexCount,
+                                   float* outError = nullptr);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef PARALLEL_RECORDER_HPP
+#define PARALLEL_RECORDER_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Records one secondary command buffer per chunk of work on separate threads, for the primary command buffer to
+// execute. Every thread (the calling one included) owns a command pool per frame in flight, reset the next time that
+// frame comes around, so recording never needs a lock:
+//
+//   auto& secondaries = recorder.record(frame, inheritance, chunkCount, [&](vk::CommandBuffer cb, uint32_t chunk) {
+//       // draws of chunk
+//   });
+//
+//   cb.executeCommands(secondaries);
+class ParallelRecorder {
+public:
+    using RecordFunction = std::function<void(vk::CommandBuffer cb, uint32_t chunk)>;
+
+    // threadCount includes the calling thread, which records chunk 0 itself. 0 is one per core.
+    bool init(vk::Device device, uint32_t queueFamily, uint32_t threadCount, uint32_t framesInFlight);
+    void destroy();
+
+    // Threads can't outlive their std::thread, init() failing halfway never gets to destroy()
+    ~ParallelRecorder() { destroy(); }
+
+    // Blocks until chunkCount (at most threadCount()) secondaries are recorded, chunk i by thread i. Only call once
+    // frame's previous submission is done. recordChunk gets the buffer already begun with inheritance and ends it
+    // as well. The returned buffers stay valid until frame is recorded again.
+    const std::vector<vk::CommandBuffer>& record(uint32_t frame, const vk::CommandBufferInheritanceInfo& inheritance,
+                                                 uint32_t chunkCount, const RecordFunction& recordChunk);
+
+    uint32_t threadCount() const { return static_cast<uint32_t>(m_pools.size()); }
+
+private:
+    void recordChunk(uint32_t thread);
+    void workerLoop(uint32_t thread);
+
+    vk::Device m_device;
+
+    // [thread][frame], thread 0 is the calling thread
+    std::vector<std::vector<vk::CommandPool>> m_pools;
+    std::vector<std::vector<vk::CommandBuffer>> m_buffers;
+
+    std::vector<std::thread> m_threads;
+
+    // Current job, only written by record() while every worker is idle
+    uint32_t m_frame = 0;
+    const vk::CommandBufferInheritanceInfo* m_inheritance = nullptr;
+    uint32_t m_chunkCount = 0;
+    const RecordFunction* m_recordChunk = nullptr;
+    std::vector<vk::CommandBuffer> m_recorded;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    uint32_t m_pending = 0;
+    bool m_stopping = false;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef PIPELINE_CACHE_HPP
+#define PIPELINE_CACHE_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <string>
+
+// vk::PipelineCache that survives restarts. init() seeds the cache from a file written by a previous run, save()
+// writes it back. Files start with a header of our own (magic, version, the device's vendor ID, device ID, driver
+// version and pipelineCacheUUID, size and hash of the data): anything written for another device or driver, or
+// truncated, is ignored and the cache starts out empty. Writes go to a temporary file that is renamed over the old
+// one, so a crash mid-write never leaves a broken cache behind.
+class PipelineCache {
+public:
+    // Never fails, a missing or mismatching file just means compiling from scratch. Empty path disables the file.
+    void init(vk::Device device, const vk::PhysicalDeviceProperties& properties, const std::string& path);
+    void destroy();
+
+    // Writes the current contents to the file, false if that didn't work out.
+    bool save();
+
+    vk::PipelineCache cache() const { return m_cache; }
+
+    // Bytes of cache data the file provided on init, 0 if it didn't.
+    size_t loadedSize() const { return m_loadedSize; }
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint32_t dataSize;
+        uint64_t dataHash;
+    };
+
+    FileHeader expectedHeader() const;
+
+    vk::Device m_device;
+    vk::PhysicalDeviceProperties m_properties;
+    std::string m_path;
+
+    vk::PipelineCache m_cache;
+    size_t m_loadedSize = 0;
+};
+
+#endif
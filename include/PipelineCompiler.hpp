@@ -0,0 +1,61 @@
+#ifndef PIPELINE_COMPILER_HPP
+#define PIPELINE_COMPILER_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PipelineStateCache.hpp"
+
+enum class CompilePriority {
+    Critical,  // Needed before the first frame, ahead of everything deferred
+    Deferred,  // Variants nothing waits on yet (hot reload, prewarming), only run once no critical job is queued
+};
+
+// Thread pool compiling pipelines through a PipelineStateCache, so startup compiles run next to each other and next
+// to whatever the main thread does meanwhile (uploads, scene setup). Drivers compile in parallel fine as long as each
+// thread creates its own pipelines, which is all the cache needs.
+//
+//   std::future<vk::Pipeline> scene = compiler.compile(desc);
+//   ...
+//   vk::Pipeline pipeline = scene.get();
+class PipelineCompiler {
+public:
+    // threadCount 0 is one thread per core but the calling one.
+    void init(PipelineStateCache& pipelines, uint32_t threadCount = 0);
+
+    // Lets queued jobs finish before joining, destroy before the cache.
+    void destroy();
+
+    // Threads can't outlive their std::thread, init() failing halfway never gets to destroy()
+    ~PipelineCompiler() { destroy(); }
+
+    // Any job producing a pipeline, for jobs that read their shaders themselves. Runs inline if there are no threads.
+    std::future<vk::Pipeline> submit(std::function<vk::Pipeline()> job, CompilePriority priority = CompilePriority::Critical);
+
+    std::future<vk::Pipeline> compile(const GraphicsPipelineDesc& desc, CompilePriority priority = CompilePriority::Critical);
+    std::future<vk::Pipeline> compile(const ComputePipelineDesc& desc, CompilePriority priority = CompilePriority::Critical);
+
+    uint32_t threadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+private:
+    void workerLoop(uint32_t index);
+
+    PipelineStateCache* m_pipelines = nullptr;
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::packaged_task<vk::Pipeline()>> m_critical;
+    std::deque<std::packaged_task<vk::Pipeline()>> m_deferred;
+    bool m_stopping = false;
+};
+
+#endif
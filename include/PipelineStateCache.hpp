@@ -0,0 +1,204 @@
+#ifndef PIPELINE_STATE_CACHE_HPP
+#define PIPELINE_STATE_CACHE_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Pipelines, pipeline layouts and descriptor set layouts described as plain values. Equal descriptions hash the same,
+// PipelineStateCache hands out one object per distinct description:
+//
+//   GraphicsPipelineDesc desc;
+//   desc.addStage(vk::ShaderStageFlagBits::eVertex, vertCode)
+//       .addStage(vk::ShaderStageFlagBits::eFragment, fragCode)
+//       .setLayout(layout)
+//       .setColorFormat(format);
+//
+//   vk::Pipeline pipeline = cache.graphicsPipeline(desc);  // Compiled once, the same handle from then on
+//
+// Shaders are identified by their SPIR-V, not by module handle (those get recycled once destroyed). The hash only
+// picks the bucket, keys keep a copy of the code so equal really means the same bytes.
+// Variants of one shader differ in their specialization constants:
+//
+//   desc.setConstant(vk::ShaderStageFlagBits::eFragment, LIGHT_COUNT_ID, 4u);
+
+void hashCombine(size_t& seed, uint64_t value);
+
+// Hash of a SPIR-V binary, what shader stages are bucketed by.
+uint64_t hashShaderCode(const void* code, size_t size);
+
+struct ShaderStageDesc {
+    vk::ShaderStageFlagBits stage = vk::ShaderStageFlagBits::eVertex;
+    uint64_t codeHash = 0;
+    std::shared_ptr<const std::vector<char>> code;  // SPIR-V, shared by copies of the description
+
+    // Specialization constants, part of the key, so every combination of values is its own pipeline
+    std::vector<vk::SpecializationMapEntry> specEntries;
+    std::vector<uint8_t> specData;
+
+    // 32 bit scalars only (uint32_t, int32_t, float, VkBool32), the sizes GLSL constant_id constants have.
+    // Setting an id again replaces its value.
+    template <typename T>
+    ShaderStageDesc& setConstant(uint32_t constantID, T value) {
+        static_assert(sizeof(T) == 4 && std::is_trivially_copyable<T>::value, "Specialization constants are 32 bit scalars");
+
+        for (const auto& e : specEntries) {
+            if (e.constantID == constantID) {
+                memcpy(specData.data() + e.offset, &value, sizeof(T));
+                return *this;
+            }
+        }
+
+        specEntries.push_back(vk::SpecializationMapEntry(constantID, static_cast<uint32_t>(specData.size()), sizeof(T)));
+        specData.resize(specData.size() + sizeof(T));
+        memcpy(specData.data() + specEntries.back().offset, &value, sizeof(T));
+
+        return *this;
+    }
+
+    bool operator==(const ShaderStageDesc& other) const {
+        // Hashes differing settles it quickly, equal ones still need the bytes compared
+        return stage == other.stage && codeHash == other.codeHash &&
+               (code == other.code || (code && other.code && *code == *other.code)) && specEntries == other.specEntries &&
+               specData == other.specData;
+    }
+};
+
+struct DescriptorSetLayoutDesc {
+    vk::DescriptorSetLayoutCreateFlags flags;
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;  // No immutable samplers
+    std::vector<vk::DescriptorBindingFlags> bindingFlags;  // Empty or one per binding
+
+    DescriptorSetLayoutDesc& addBinding(uint32_t binding, vk::DescriptorType type, uint32_t count, vk::ShaderStageFlags stages,
+                                        vk::DescriptorBindingFlags flags = {});
+
+    size_t hash() const;
+    bool operator==(const DescriptorSetLayoutDesc& other) const;
+};
+
+struct PipelineLayoutDesc {
+    std::vector<vk::DescriptorSetLayout> setLayouts;
+    std::vector<vk::PushConstantRange> pushConstants;
+
+    PipelineLayoutDesc& addSetLayout(vk::DescriptorSetLayout layout);
+    PipelineLayoutDesc& addPushConstants(vk::ShaderStageFlags stages, uint32_t offset, uint32_t size);
+
+    size_t hash() const;
+    bool operator==(const PipelineLayoutDesc& other) const;
+};
+
+// Fixed function state the renderer actually varies, everything else is the same for every pipeline (no depth,
+// no blending beyond on/off, one sample). Viewport and scissor are always dynamic.
+struct GraphicsPipelineDesc {
+    std::vector<ShaderStageDesc> stages;
+
+    std::vector<vk::VertexInputBindingDescription> vertexBindings;
+    std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
+
+    vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+    vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+    vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+    vk::FrontFace frontFace = vk::FrontFace::eClockwise;
+    bool blendEnable = false;
+
+    vk::PipelineLayout layout;
+
+    // Render pass if set, dynamic rendering into colorFormat otherwise
+    vk::RenderPass renderPass;
+    uint32_t subpass = 0;
+    vk::Format colorFormat = vk::Format::eUndefined;
+
+    // Copies code, the description doesn't depend on it staying alive
+    GraphicsPipelineDesc& addStage(vk::ShaderStageFlagBits stage, const std::vector<char>& code);
+    GraphicsPipelineDesc& setVertexInput(std::vector<vk::VertexInputBindingDescription> bindings,
+                                         std::vector<vk::VertexInputAttributeDescription> attributes);
+    GraphicsPipelineDesc& setRasterizer(vk::PolygonMode polygon, vk::CullModeFlags cull, vk::FrontFace front);
+    GraphicsPipelineDesc& setLayout(vk::PipelineLayout pipelineLayout);
+    GraphicsPipelineDesc& setRenderPass(vk::RenderPass pass, uint32_t subpassIndex = 0);
+    GraphicsPipelineDesc& setColorFormat(vk::Format format);
+
+    // On the stage added with addStage() before, see ShaderStageDesc::setConstant().
+    template <typename T>
+    GraphicsPipelineDesc& setConstant(vk::ShaderStageFlagBits stage, uint32_t constantID, T value) {
+        for (auto& s : stages) {
+            if (s.stage == stage) {
+                s.setConstant(constantID, value);
+            }
+        }
+
+        return *this;
+    }
+
+    size_t hash() const;
+    bool operator==(const GraphicsPipelineDesc& other) const;
+};
+
+struct ComputePipelineDesc {
+    ShaderStageDesc stage;
+    vk::PipelineLayout layout;
+
+    ComputePipelineDesc& setShader(const std::vector<char>& code);
+    ComputePipelineDesc& setLayout(vk::PipelineLayout pipelineLayout);
+
+    template <typename T>
+    ComputePipelineDesc& setConstant(uint32_t constantID, T value) {
+        stage.setConstant(constantID, value);
+        return *this;
+    }
+
+    size_t hash() const;
+    bool operator==(const ComputePipelineDesc& other) const;
+};
+
+template <typename Desc>
+struct DescHash {
+    size_t operator()(const Desc& desc) const { return desc.hash(); }
+};
+
+// Owns everything it hands out, destroy() cleans up all of it. Lookups and creation are thread safe, creation
+// happens outside of the lock so pipelines can be compiled on several threads at once.
+class PipelineStateCache {
+public:
+    // vkCache (the on disk one, see PipelineCache.hpp) is used for every pipeline created.
+    void init(vk::Device device, vk::PipelineCache vkCache = VK_NULL_HANDLE);
+    void destroy();
+
+    vk::DescriptorSetLayout descriptorSetLayout(const DescriptorSetLayoutDesc& desc);
+    vk::PipelineLayout pipelineLayout(const PipelineLayoutDesc& desc);
+
+    // VK_NULL_HANDLE if creation failed, failures aren't cached.
+    vk::Pipeline graphicsPipeline(const GraphicsPipelineDesc& desc);
+    vk::Pipeline computePipeline(const ComputePipelineDesc& desc);
+
+    // Forgets a pipeline without destroying it, the caller destroys it once nothing uses it anymore (hot reload
+    // retiring a pipeline whose shaders changed). False if the cache doesn't know it.
+    bool release(vk::Pipeline pipeline);
+
+    size_t pipelineCount() const;
+
+private:
+    vk::Pipeline createGraphicsPipeline(const GraphicsPipelineDesc& desc) const;
+    vk::Pipeline createComputePipeline(const ComputePipelineDesc& desc) const;
+
+    // Inserts created unless another thread got there first, returns whichever ended up in the map.
+    template <typename Desc>
+    vk::Pipeline insertPipeline(std::unordered_map<Desc, vk::Pipeline, DescHash<Desc>>& map, Desc desc, vk::Pipeline created);
+
+    vk::Device m_device;
+    vk::PipelineCache m_vkCache;
+
+    mutable std::mutex m_mutex;
+
+    std::unordered_map<DescriptorSetLayoutDesc, vk::DescriptorSetLayout, DescHash<DescriptorSetLayoutDesc>> m_setLayouts;
+    std::unordered_map<PipelineLayoutDesc, vk::PipelineLayout, DescHash<PipelineLayoutDesc>> m_pipelineLayouts;
+    std::unordered_map<GraphicsPipelineDesc, vk::Pipeline, DescHash<GraphicsPipelineDesc>> m_graphicsPipelines;
+    std::unordered_map<ComputePipelineDesc, vk::Pipeline, DescHash<ComputePipelineDesc>> m_computePipelines;
+};
+
+#endif
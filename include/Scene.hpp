@@ -1,21 +1,225 @@
 #ifndef SCENE_HPP
 #define SCENE_HPP
 
+#include <memory>
+#include <string>
+
+#include "Bindless.hpp"
 #include "Mesh.hpp"
+#include "TransferQueue.hpp"
+
+struct LodRange {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.f;
+};
+
+// Where a mesh lives inside the scene's shared geometry buffers. Indices stay local to the mesh,
+// vertexOffset is added by the GPU on fetch. All LODs share the vertex range, their indices follow LOD 0.
+struct MeshRange {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+
+    std::vector<LodRange> lods;  // lods[0] is the full mesh
+
+    VertexDequant dequant;  // Identity for VertexFormat::Float32
+};
+
+// Defaults to identity, i.e. world space == clip space, which is what the hand written meshes are authored in.
+struct Camera {
+    glm::mat4 view{1.f};
+    glm::mat4 projection{1.f};
+
+    glm::mat4 viewProjection() const { return projection * view; }
+};
+
+// Camera uniform block of shader.vert, written into the frame allocator every frame.
+struct CameraUbo {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+};
+
+// Push constants of the scene pass, set once per frame. shader.frag only reads the first member, the rest is for
+// vertex pulling (shader_pull.vert).
+struct ScenePushConstants {
+    uint32_t materialBuffer = BINDLESS_INVALID_SLOT;  // Bindless storage buffer slot of Scene::materialBuffer
+    uint32_t pad = 0;
+    vk::DeviceAddress vertices = 0;                   // Scene::vertexBuffer
+    vk::DeviceAddress instances = 0;                  // Scene::visibleInstanceBuffer, InstanceVertex
+};
+
+static_assert(sizeof(ScenePushConstants) == 24, "Has to match the push constant blocks of the scene shaders");
+
+// Specialization constant ids of the scene shaders (constant_id in GLSL)
+constexpr uint32_t SPEC_VERTEX_FORMAT = 0;  // shader_pull.vert, VertexFormat of vertices
+
+// Surface description, instances refer to one by their index into Scene::materials. Texture and sampler are slots
+// of the bindless arrays (see Bindless.hpp), the defaults sample plain white.
+struct Material {
+    glm::vec4 baseColor{1.f};
+    uint32_t texture = BINDLESS_DEFAULT_IMAGE;
+    uint32_t sampler = BINDLESS_DEFAULT_SAMPLER;
+};
+
+// One placed copy of a mesh.
+struct Instance {
+    glm::mat4 transform{1.f};
+    glm::vec4 color{1.f};
+    uint32_t mesh = 0;
+    uint32_t material = 0;
+};
+
+// All instances of one mesh, contiguous in Scene::instances once uploaded and drawn as a single instanced draw.
+struct InstanceBatch {
+    uint32_t mesh = 0;
+    uint32_t firstInstance = 0;
+    uint32_t instanceCount = 0;
+};
+
+// GPU side layouts, std430 in cull.comp (GpuMaterial in shader.frag).
+struct GpuInstance {
+    glm::mat4 transform;
+    glm::vec4 color;
+    uint32_t batch;
+    uint32_t material;
+    uint32_t pad[2];
+};
+
+struct GpuBatch {
+    uint32_t mesh;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+    uint32_t drawChunk;       // Index into Scene::drawChunks, its draw count
+    uint32_t chunkFirstDraw;  // DrawChunk::firstDraw of that chunk
+    uint32_t pad[3];
+};
+
+// Contiguous range of batches with its own part of the indirect buffer and its own draw count, so each can be
+// recorded as a separate drawIndexedIndirectCount (by separate threads, see ParallelRecorder.hpp).
+struct DrawChunk {
+    uint32_t firstDraw = 0;     // In commands
+    uint32_t maxDrawCount = 0;  // Its batches * MAX_MESH_LODS
+};
+
+struct GpuMeshLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+    uint32_t pad;
+};
+
+struct GpuMeshInfo {
+    int32_t vertexOffset;
+    uint32_t lodCount;
+    uint32_t pad[2];
+    glm::vec4 sphere;
+    glm::vec4 dequantScale;   // xyz
+    glm::vec4 dequantOffset;  // xyz
+    GpuMeshLod lods[MAX_MESH_LODS];
+};
+
+struct GpuMaterial {
+    glm::vec4 baseColor;
+    uint32_t textureIndex;  // Bindless slots, "sampler" is a keyword in Vulkan GLSL
+    uint32_t samplerIndex;
+    uint32_t pad[2];
+};
 
 struct Scene {
     Scene() = default;
+    virtual ~Scene() = default;
 
-    virtual void uploadMeshes(vma::Allocator&, vk::CommandBuffer, vk::Queue) = 0;
+    // Default packs every mesh into one vertex and one index buffer, see Scene.cpp.
+    virtual void uploadMeshes(vma::Allocator&, TransferQueue&);
+
+    void destroyBuffers(vma::Allocator& allocator);
+
+    // Called by App with the render extent on init and whenever the swapchain gets recreated. Scenes with a
+    // perspective camera fit its aspect ratio here, the default camera is extent independent.
+    virtual void resize(uint32_t width, uint32_t height) {}
+
+    // Submits transforms.size() copies of a mesh, all of them end up in one instanced draw.
+    // Has to happen before uploadMeshes().
+    void addInstances(uint32_t mesh, const std::vector<glm::mat4>& transforms, glm::vec4 color = glm::vec4(1.f), uint32_t material = 0);
 
     std::vector<Mesh> meshes;
-    AllocatedBuffer buffer;  // Both vertex and Index buffers can be housed here (I think)
+    std::vector<Instance> instances;  // One identity instance per mesh gets added on upload if left empty
+    std::vector<Material> materials;  // A default material gets added on upload if left empty
+    Camera camera;
+
+    // Built on upload, instances get sorted by mesh so that every batch is a contiguous range.
+    std::vector<InstanceBatch> batches;
+
+    // How many DrawChunks the batches get split into on upload, at most one per batch. Has to be set before
+    // uploadMeshes().
+    uint32_t drawChunkCount = 1;
+
+    // Build LOD chains for meshes that don't have one on upload.
+    bool generateLods = true;
+
+    // Layout of vertexBuffer, the graphics pipeline's vertex input follows it. Has to be set before App::init().
+    VertexFormat vertexFormat = VertexFormat::Float32;
+
+    // Geometry of all meshes, bound once per frame. meshRanges[i] locates meshes[i]. Vertex and visible instance
+    // buffers can be read through their device address as well (vertex pulling).
+    AllocatedBuffer vertexBuffer;
+    AllocatedBuffer indexBuffer;
+    vk::IndexType indexType = vk::IndexType::eUint32;
+    std::vector<MeshRange> meshRanges;
+
+    // Culling inputs, GpuInstance/GpuMeshInfo/GpuBatch arrays.
+    AllocatedBuffer instanceBuffer;
+    AllocatedBuffer meshInfoBuffer;
+    AllocatedBuffer batchBuffer;
+
+    // GpuMaterial array, read by the fragment shader through the bindless storage buffer array.
+    AllocatedBuffer materialBuffer;
+
+    // Written every frame by the culling pass: per (batch, LOD) visible counts and per instance slots (scratch), the
+    // visible InstanceVertex stream bound on binding 1, one vk::DrawIndexedIndirectCommand per non empty
+    // (batch, LOD) compacted within its draw chunk's range and one count per chunk, consumed by
+    // drawIndexedIndirectCount.
+    AllocatedBuffer batchCountBuffer;
+    AllocatedBuffer instanceSlotBuffer;
+    AllocatedBuffer visibleInstanceBuffer;
+    AllocatedBuffer indirectBuffer;
+    AllocatedBuffer countBuffer;
+    uint32_t maxDrawCount = 0;
+    std::vector<DrawChunk> drawChunks;
 };
 
 struct MainScene : public Scene {
     MainScene();
+};
+
+// side * side small triangles, each its own mesh, to stress per mesh costs.
+struct GridScene : public Scene {
+    explicit GridScene(uint32_t side);
+};
 
-    void uploadMeshes(vma::Allocator&, vk::CommandBuffer, vk::Queue) override;
+// Two meshes sharing side * side instances, foliage/props style.
+struct InstancedScene : public Scene {
+    explicit InstancedScene(uint32_t side);
 };
 
-#endif
\ No newline at end of file
+// Lots of dense spheres spread out in depth under a perspective camera, exercises LOD selection.
+struct LodScene : public Scene {
+    explicit LodScene(uint32_t count);
+
+    void resize(uint32_t width, uint32_t height) override;
+};
+
+/// @brief Looks a scene up by name, used by the command line front ends (main, atom_bench).
+/// @return nullptr if no scene with that name exists.
+std::unique_ptr<Scene> createScene(const std::string& name);
+
+/// @brief "float", "half" or "snorm16", for the same front ends.
+/// @return false if the name is unknown, format is left alone then.
+bool vertexFormatFromName(const std::string& name, VertexFormat& format);
+
+const char* vertexFormatName(VertexFormat format);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SHADER_LIBRARY_HPP
+#define SHADER_LIBRARY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// SPIR-V compiled and embedded by the build, see atom3d_embed_shader() in CMakeLists.txt.
+struct EmbeddedShader {
+    const char* name;  // File name it would have on disk, "vert.spv"
+    const uint32_t* code;
+    size_t size;  // In bytes
+};
+
+extern const EmbeddedShader EMBEDDED_SHADERS[];
+extern const size_t EMBEDDED_SHADER_COUNT;
+
+// nullptr if there's no shader of that name.
+const EmbeddedShader* findEmbeddedShader(const std::string& name);
+
+// Where shaders come from. The embedded ones by default, no file I/O and no dependence on the working directory.
+// With an override directory, a valid .spv file of the same name in it takes precedence, which is what shader hot
+// reload watches (make shaders writes them to src/shaders).
+class ShaderLibrary {
+public:
+    // Empty overrideDir uses the embedded shaders only.
+    void init(const std::string& overrideDir);
+
+    // False if name is neither in the override directory nor embedded. Safe to call from any thread.
+    bool load(const std::string& name, std::vector<char>& code) const;
+
+    const std::string& overrideDir() const { return m_overrideDir; }
+
+private:
+    std::string m_overrideDir;
+};
+
+#endif
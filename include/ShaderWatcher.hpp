@@ -0,0 +1,45 @@
+#ifndef SHADER_WATCHER_HPP
+#define SHADER_WATCHER_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// How long a changed file has to be left alone before it's reported. Compilers and editors tend to write in several
+// steps, this keeps half written SPIR-V from being picked up.
+constexpr std::chrono::milliseconds SHADER_WATCH_SETTLE_TIME(100);
+
+// Watches a shader directory for files being written, for hot reloading. Uses inotify on Linux and compares
+// modification times elsewhere (scanning at most every SHADER_WATCH_SETTLE_TIME). Never blocks.
+class ShaderWatcher {
+public:
+    bool init(const std::string& directory);
+    void destroy();
+
+    // Names (without the directory) of the files that changed since the last call and have settled.
+    std::vector<std::string> poll();
+
+    bool active() const { return m_active; }
+
+private:
+    void gatherChanges();
+
+    std::string m_directory;
+    bool m_active = false;
+
+    std::set<std::string> m_changed;
+    std::chrono::steady_clock::time_point m_lastChange;
+
+#if defined(__linux__)
+    int m_fd = -1;
+    int m_watch = -1;
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_writeTimes;
+    std::chrono::steady_clock::time_point m_lastScan;
+#endif
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef STAGING_RING_HPP
+#define STAGING_RING_HPP
+
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include "AllocatedBuffer.hpp"
+
+constexpr vk::DeviceSize STAGING_RING_SIZE = 64ull << 20;
+constexpr vk::DeviceSize STAGING_RING_ALIGNMENT = 16;
+
+// One persistently mapped host buffer handed out front to back and reclaimed in the same order. Positions are
+// counted monotonically (they never wrap, the physical offset is position % size), so "everything before marker X is
+// free again" is a single compare. Users remember head() after their allocations and release() it once the GPU
+// has read them.
+class StagingRing {
+public:
+    bool init(vma::Allocator allocator, vk::DeviceSize size = STAGING_RING_SIZE);
+    void destroy();
+
+    // Writes size bytes of data into the ring. Returns false if there's not enough room until older allocations are
+    // released, or if size doesn't fit at all (see capacity()).
+    bool push(const void* data, vk::DeviceSize size, vk::DeviceSize& offset);
+
+    // Marks everything allocated before marker as consumed.
+    void release(uint64_t marker);
+
+    uint64_t head() const { return m_head; }
+    vk::DeviceSize capacity() const { return m_size; }
+    vk::DeviceSize used() const { return m_head - m_tail; }
+
+    vk::Buffer buffer() const { return m_buffer.buffer; }
+
+private:
+    vma::Allocator m_allocator;
+    AllocatedBuffer m_buffer;
+    uint8_t* m_mapped = nullptr;
+
+    vk::DeviceSize m_size = 0;
+    uint64_t m_head = 0;
+    uint64_t m_tail = 0;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef TIMELINE_SEMAPHORE_HPP
+#define TIMELINE_SEMAPHORE_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+
+// Counter that lives on the GPU (VK_KHR_timeline_semaphore, core in 1.2). Every submission signals the next value,
+// and a signal also covers everything submitted to that queue before it. "Has submission N finished" is then a
+// compare against the counter, and waiting on N waits on exactly that work and nothing newer.
+class TimelineSemaphore {
+public:
+    bool init(vk::Device device);
+    void destroy();
+
+    // Value for the submission that's about to happen, counts as signaled from here on.
+    uint64_t nextValue() { return ++m_lastSignaled; }
+
+    // Highest value handed to a submission so far.
+    uint64_t lastSignaled() const { return m_lastSignaled; }
+
+    // Highest value the GPU has reached.
+    uint64_t completed() const;
+
+    bool isDone(uint64_t value) const { return value <= m_completed || value <= completed(); }
+
+    // Blocks until value is reached, false on timeout or device loss.
+    bool wait(uint64_t value, uint64_t timeout = UINT64_MAX) const;
+
+    vk::Semaphore semaphore() const { return m_semaphore; }
+
+private:
+    vk::Device m_device;
+    vk::Semaphore m_semaphore;
+
+    uint64_t m_lastSignaled = 0;
+    mutable uint64_t m_completed = 0;  // Cached counter value, saves a driver call for values known to be done
+};
+
+#endif
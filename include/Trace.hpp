@@ -0,0 +1,63 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <string>
+
+// Scoped CPU zones for per-phase frame timelines. Every thread records into its own fixed size ring buffer
+// (oldest events get overwritten), Trace::dumpChromeJson() writes everything currently buffered in the
+// Chrome trace event format, which chrome://tracing and ui.perfetto.dev both open.
+//
+// Zones are compiled out unless ATOM3D_ENABLE_TRACING is defined (CMake option of the same name). Compiled in, they
+// only record once setEnabled(true) was called, main and atom_bench do that for --trace.
+
+constexpr uint32_t TRACE_EVENTS_PER_THREAD = 1 << 16;
+
+struct TraceEvent {
+    const char* name;  // Must be a string literal, only the pointer is stored
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+class Trace {
+public:
+    static void setEnabled(bool enabled);
+    static bool enabled();
+
+    // Shows up as the thread's name in the trace viewer.
+    static void setThreadName(const std::string& name);
+
+    static uint64_t nowNs();
+    static void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+    static bool dumpChromeJson(const std::string& path);
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name)
+        : m_name(name), m_startNs(Trace::enabled() ? Trace::nowNs() : 0) {}
+
+    ~TraceScope() {
+        if (m_startNs != 0) {
+            Trace::record(m_name, m_startNs, Trace::nowNs());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_startNs;
+};
+
+#if defined(ATOM3D_ENABLE_TRACING)
+#define ATOM3D_TRACE_CONCAT_INNER(a, b) a##b
+#define ATOM3D_TRACE_CONCAT(a, b) ATOM3D_TRACE_CONCAT_INNER(a, b)
+#define ATOM3D_TRACE_SCOPE(name) TraceScope ATOM3D_TRACE_CONCAT(atomTraceScope_, __LINE__)(name)
+#else
+#define ATOM3D_TRACE_SCOPE(name)
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TRANSFER_QUEUE_HPP
+#define TRANSFER_QUEUE_HPP
+
+#include <VkBootstrap.h>
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <vector>
+
+#include "AllocatedBuffer.hpp"
+#include "StagingRing.hpp"
+#include "TimelineSemaphore.hpp"
+
+// Stages on the graphics queue that may read uploaded buffers: culling inputs (compute), indirect arguments,
+// vertex/index fetch and bindless storage buffers (materials). Graphics submissions wait on uploads right before
+// these.
+constexpr vk::PipelineStageFlags UPLOAD_CONSUMER_STAGES = vk::PipelineStageFlagBits::eComputeShader |
+                                                          vk::PipelineStageFlagBits::eDrawIndirect |
+                                                          vk::PipelineStageFlagBits::eVertexInput |
+                                                          vk::PipelineStageFlagBits::eVertexShader |
+                                                          vk::PipelineStageFlagBits::eFragmentShader;
+
+// Buffer uploads on the dedicated transfer queue, without ever waiting for the device.
+//
+// Data is staged in a persistently mapped ring (StagingRing), copies are recorded into a batch as they come in and
+// flush(), once a frame, submits the whole batch to the transfer queue as one command buffer, signaling the next
+// value of the transfer timeline. The next graphics submission picks flushed batches up through acquire(): it waits
+// for the newest of those values and records the queue family ownership acquire of every written range (matching
+// the release recorded on the transfer side). collect() reclaims ring space and command buffers as soon as the
+// timeline has passed a batch.
+//
+// Devices without a separate transfer family (MoltenVK, some integrated GPUs) use the graphics queue for the same
+// flow, ownership transfers are skipped then.
+class TransferQueue {
+public:
+    bool init(vk::Device device, const vkb::Device& vkbDevice, vma::Allocator allocator);
+    void destroy();
+
+    // Copies data into dst through the staging ring, dst needs TransferDst usage and must not be in use by the
+    // graphics queue until the submission that acquire()s it. Blocks on the oldest batch only if the ring is full,
+    // uploads bigger than the whole ring get a staging buffer of their own.
+    void upload(vk::Buffer dst, vk::DeviceSize offset, const void* data, size_t size);
+
+    // Device local buffer with usage | TransferDst, filled through upload().
+    AllocatedBuffer createBuffer(const void* data, size_t size, vk::BufferUsageFlags usage);
+
+    // Submits everything uploaded since the last flush in one go.
+    void flush();
+
+    // Hands flushed batches over to a graphics command buffer (outside of a render pass). The submission of cb has
+    // to wait on the appended semaphore, stage and timeline value.
+    void acquire(vk::CommandBuffer cb, std::vector<vk::Semaphore>& waitSemaphores, std::vector<vk::PipelineStageFlags>& waitStages,
+                 std::vector<uint64_t>& waitValues);
+
+    // Reclaims staging space and batches the transfer queue is done with, cheap enough to call every frame.
+    void collect();
+
+    bool dedicated() const { return m_transferFamily != m_graphicsFamily; }
+    bool idle() const { return m_batches.empty() && !m_recording; }
+
+    // Transfer timeline value of the last flush, for waiting on uploads from the CPU.
+    uint64_t lastFlushed() const { return m_timeline.lastSignaled(); }
+    const TimelineSemaphore& timeline() const { return m_timeline; }
+
+private:
+    struct Batch {
+        vk::CommandBuffer cb;
+        uint64_t value = 0;     // Transfer timeline value signaled on completion
+        bool acquired = false;  // Handed over to a graphics submission
+
+        uint64_t stagingEnd = 0;  // Ring head after the batch's last upload
+        std::vector<AllocatedBuffer> staging;  // Oversized uploads only
+        std::vector<vk::BufferMemoryBarrier> acquires;
+    };
+
+    Batch& recording();
+    void recycle(Batch& batch);
+    void reclaimStaging();
+
+    vk::Device m_device;
+    vma::Allocator m_allocator;
+
+    vk::Queue m_queue;
+    uint32_t m_transferFamily = 0;
+    uint32_t m_graphicsFamily = 0;
+
+    vk::CommandPool m_commandPool;
+    StagingRing m_ring;
+    TimelineSemaphore m_timeline;
+
+    Batch m_current;
+    bool m_recording = false;
+
+    std::vector<Batch> m_batches;  // Flushed, oldest first
+    std::vector<Batch> m_free;
+};
+
+#endif
@@ -4,24 +4,134 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <array>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.hpp>
 
+#include "VertexLayout.hpp"
+
+// Layout of the scene's vertex buffer. The compact ones store positions relative to the mesh's bounding box
+// ([-1, 1] on every axis), the culling pass folds the per mesh dequantization into the instance transform.
+enum class VertexFormat {
+    Float32,  // Vertex, 32 bytes
+    Half,     // PackedVertex with half float positions, 16 bytes
+    Snorm16,  // PackedVertex with 16 bit normalized positions, 16 bytes
+};
+
+// Compact vertex, the pos bits depend on the VertexFormat. Color is RGBA8 unorm and texCoord two halfs, which keeps
+// UVs outside of [0, 1] working. The shader inputs stay floats, the fetch converts.
+struct PackedVertex {
+    uint64_t pos;       // xyz + unused w, R16G16B16A16 sfloat or snorm
+    uint32_t color;     // R8G8B8A8 unorm
+    uint32_t texCoord;  // R16G16 sfloat
+};
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex is supposed to be half of Vertex");
+
 struct Vertex {
     glm::vec3 pos;
     glm::vec3 color;
     glm::vec2 texCoord;
 
-    static vk::VertexInputBindingDescription getBindingDescription() {
-        return vk::VertexInputBindingDescription(0, sizeof(Vertex), vk::VertexInputRate::eVertex);
+    // Pick between the layouts below, see VertexLayout.hpp.
+    static vk::VertexInputBindingDescription getBindingDescription(VertexFormat format = VertexFormat::Float32);
+    static std::array<vk::VertexInputAttributeDescription, 3> getAttrDesc(VertexFormat format = VertexFormat::Float32);
+
+    // Bitwise on purpose so that it agrees with VertexHash, +0.0/-0.0 and NaNs just don't get welded.
+    bool operator==(const Vertex& other) const {
+        return memcmp(this, &other, sizeof(Vertex)) == 0;
     }
+};
+
+// Per instance stream on binding 1, same layout as VisibleInstance in cull.comp which fills it.
+struct InstanceVertex {
+    glm::mat4 transform;
+    glm::vec4 color;
+    uint32_t material;
+    uint32_t pad[3];  // std430 struct size
+
+    static vk::VertexInputBindingDescription getBindingDescription();
+    static std::array<vk::VertexInputAttributeDescription, 6> getAttrDesc();
+};
+
+static_assert(sizeof(InstanceVertex) == 96, "InstanceVertex has to match VisibleInstance in cull.comp");
+
+using FloatVertexLayout = VertexLayout<Vertex, 0, vk::VertexInputRate::eVertex,
+                                       VertexAttribute<0, glm::vec3, offsetof(Vertex, pos)>,
+                                       VertexAttribute<1, glm::vec3, offsetof(Vertex, color)>,
+                                       VertexAttribute<2, glm::vec2, offsetof(Vertex, texCoord)>>;
+
+using HalfVertexLayout = VertexLayout<PackedVertex, 0, vk::VertexInputRate::eVertex,
+                                      VertexAttribute<0, glm::vec3, offsetof(PackedVertex, pos), vk::Format::eR16G16B16A16Sfloat>,
+                                      VertexAttribute<1, glm::vec3, offsetof(PackedVertex, color), vk::Format::eR8G8B8A8Unorm>,
+                                      VertexAttribute<2, glm::vec2, offsetof(PackedVertex, texCoord), vk::Format::eR16G16Sfloat>>;
+
+using Snorm16VertexLayout = VertexLayout<PackedVertex, 0, vk::VertexInputRate::eVertex,
+                                         VertexAttribute<0, glm::vec3, offsetof(PackedVertex, pos), vk::Format::eR16G16B16A16Snorm>,
+                                         VertexAttribute<1, glm::vec3, offsetof(PackedVertex, color), vk::Format::eR8G8B8A8Unorm>,
+                                         VertexAttribute<2, glm::vec2, offsetof(PackedVertex, texCoord), vk::Format::eR16G16Sfloat>>;
+
+// The mat4 takes locations 3 - 6
+using InstanceVertexLayout = VertexLayout<InstanceVertex, 1, vk::VertexInputRate::eInstance,
+                                          VertexAttribute<3, glm::mat4, offsetof(InstanceVertex, transform)>,
+                                          VertexAttribute<7, glm::vec4, offsetof(InstanceVertex, color)>,
+                                          VertexAttribute<8, uint32_t, offsetof(InstanceVertex, material)>>;
+
+// Hand maintained mirror of shader.vert's layout(location = ...) inputs, nothing reads them out of the shader. The
+// asserts below only check the C++ layouts against this list, so a change to the shader has to be copied here by
+// hand or it goes unnoticed until validation complains at pipeline creation.
+using SceneVertexShaderInputs = ShaderInputs<ShaderInput<0, glm::vec3>,
+                                             ShaderInput<1, glm::vec3>,
+                                             ShaderInput<2, glm::vec2>,
+                                             ShaderInput<3, glm::mat4>,
+                                             ShaderInput<7, glm::vec4>,
+                                             ShaderInput<8, uint32_t>>;
+
+static_assert(SceneVertexShaderInputs::matches<FloatVertexLayout, InstanceVertexLayout>(), "Vertex doesn't match shader.vert");
+static_assert(SceneVertexShaderInputs::matches<HalfVertexLayout, InstanceVertexLayout>(), "Half vertices don't match shader.vert");
+static_assert(SceneVertexShaderInputs::matches<Snorm16VertexLayout, InstanceVertexLayout>(), "Snorm16 vertices don't match shader.vert");
+
+inline vk::VertexInputBindingDescription Vertex::getBindingDescription(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Half:
+            return HalfVertexLayout::bindingDescription;
+        case VertexFormat::Snorm16:
+            return Snorm16VertexLayout::bindingDescription;
+        default:
+            return FloatVertexLayout::bindingDescription;
+    }
+}
+
+inline std::array<vk::VertexInputAttributeDescription, 3> Vertex::getAttrDesc(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Half:
+            return HalfVertexLayout::attributeDescriptions;
+        case VertexFormat::Snorm16:
+            return Snorm16VertexLayout::attributeDescriptions;
+        default:
+            return FloatVertexLayout::attributeDescriptions;
+    }
+}
+
+inline vk::VertexInputBindingDescription InstanceVertex::getBindingDescription() {
+    return InstanceVertexLayout::bindingDescription;
+}
+
+inline std::array<vk::VertexInputAttributeDescription, 6> InstanceVertex::getAttrDesc() {
+    return InstanceVertexLayout::attributeDescriptions;
+}
+
+// FNV-1a over the raw vertex bytes.
+struct VertexHash {
+    size_t operator()(const Vertex& v) const {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&v);
+        uint64_t h = 14695981039346656037ull;
 
-    static std::array<vk::VertexInputAttributeDescription, 3> getAttrDesc() {
-        vk::VertexInputAttributeDescription p(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, pos));
-        vk::VertexInputAttributeDescription c(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, color));
-        vk::VertexInputAttributeDescription t(2, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, texCoord));
+        for (size_t i = 0; i < sizeof(Vertex); i++) {
+            h = (h ^ bytes[i]) * 1099511628211ull;
+        }
 
-        return {p, c, t};
+        return static_cast<size_t>(h);
     }
 };
 
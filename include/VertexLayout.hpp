@@ -0,0 +1,217 @@
+#ifndef VERTEX_LAYOUT_HPP
+#define VERTEX_LAYOUT_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+// Compile time vertex input descriptions. A vertex type lists its attributes once as a VertexLayout, binding and
+// attribute descriptions come out of that as constexpr arrays, and ShaderInputs::matches() checks the layouts
+// against a shader's input locations in a static_assert:
+//
+//   using MyLayout = VertexLayout<MyVertex, 0, vk::VertexInputRate::eVertex,
+//                                 VertexAttribute<0, glm::vec3, offsetof(MyVertex, pos)>,
+//                                 VertexAttribute<1, glm::vec4, offsetof(MyVertex, color), vk::Format::eR8G8B8A8Unorm>>;
+//
+// Attribute types are the types the shader sees, the optional format describes the storage when it differs.
+
+// Shader side type -> default attribute format and how many locations it takes.
+template <typename T>
+struct AttributeTraits;
+
+template <>
+struct AttributeTraits<float> {
+    static constexpr vk::Format format = vk::Format::eR32Sfloat;
+    static constexpr uint32_t components = 1;
+    static constexpr uint32_t locations = 1;
+    static constexpr bool integer = false;
+};
+
+template <>
+struct AttributeTraits<glm::vec2> {
+    static constexpr vk::Format format = vk::Format::eR32G32Sfloat;
+    static constexpr uint32_t components = 2;
+    static constexpr uint32_t locations = 1;
+    static constexpr bool integer = false;
+};
+
+template <>
+struct AttributeTraits<glm::vec3> {
+    static constexpr vk::Format format = vk::Format::eR32G32B32Sfloat;
+    static constexpr uint32_t components = 3;
+    static constexpr uint32_t locations = 1;
+    static constexpr bool integer = false;
+};
+
+template <>
+struct AttributeTraits<glm::vec4> {
+    static constexpr vk::Format format = vk::Format::eR32G32B32A32Sfloat;
+    static constexpr uint32_t components = 4;
+    static constexpr uint32_t locations = 1;
+    static constexpr bool integer = false;
+};
+
+template <>
+struct AttributeTraits<uint32_t> {
+    static constexpr vk::Format format = vk::Format::eR32Uint;
+    static constexpr uint32_t components = 1;
+    static constexpr uint32_t locations = 1;
+    static constexpr bool integer = true;
+};
+
+template <>
+struct AttributeTraits<glm::uvec4> {
+    static constexpr vk::Format format = vk::Format::eR32G32B32A32Uint;
+    static constexpr uint32_t components = 4;
+    static constexpr uint32_t locations = 1;
+    static constexpr bool integer = true;
+};
+
+// Matrices take one location per column
+template <>
+struct AttributeTraits<glm::mat4> {
+    static constexpr vk::Format format = vk::Format::eR32G32B32A32Sfloat;
+    static constexpr uint32_t components = 4;
+    static constexpr uint32_t locations = 4;
+    static constexpr bool integer = false;
+};
+
+// What a shader input or a vertex attribute looks like from the shader's side.
+struct ShaderInputInfo {
+    uint32_t location;
+    uint32_t components;
+    uint32_t locations;
+    bool integer;
+};
+
+struct VertexAttributeInfo {
+    uint32_t location;
+    uint32_t locations;
+    vk::Format format;
+    uint32_t offset;
+    uint32_t locationStride;  // Offset between the locations of a matrix
+};
+
+template <uint32_t Location, typename T, size_t Offset, vk::Format Format = AttributeTraits<T>::format>
+struct VertexAttribute {
+    using Traits = AttributeTraits<T>;
+
+    static_assert(Traits::locations == 1 || Format == Traits::format, "Matrix attributes can't change their storage format");
+
+    static constexpr VertexAttributeInfo attribute = {Location, Traits::locations, Format, static_cast<uint32_t>(Offset),
+                                                      static_cast<uint32_t>(sizeof(T) / Traits::locations)};
+    static constexpr ShaderInputInfo input = {Location, Traits::components, Traits::locations, Traits::integer};
+};
+
+template <uint32_t Location, typename T>
+struct ShaderInput {
+    using Traits = AttributeTraits<T>;
+
+    static constexpr ShaderInputInfo input = {Location, Traits::components, Traits::locations, Traits::integer};
+};
+
+namespace vertex_layout_detail {
+
+template <size_t N>
+constexpr std::array<vk::VertexInputAttributeDescription, N> buildAttributes(uint32_t binding, const VertexAttributeInfo* attributes, size_t count) {
+    std::array<vk::VertexInputAttributeDescription, N> out{};
+    size_t n = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        for (uint32_t l = 0; l < attributes[i].locations; l++) {
+            out[n++] = vk::VertexInputAttributeDescription(attributes[i].location + l, binding, attributes[i].format,
+                                                           attributes[i].offset + l * attributes[i].locationStride);
+        }
+    }
+
+    return out;
+}
+
+template <size_t N, size_t M>
+constexpr void append(std::array<ShaderInputInfo, N>& out, size_t& n, const std::array<ShaderInputInfo, M>& in) {
+    for (size_t i = 0; i < M; i++) {
+        out[n++] = in[i];
+    }
+}
+
+template <typename... Layouts>
+constexpr auto gatherInputs() {
+    std::array<ShaderInputInfo, (std::tuple_size<decltype(Layouts::inputs)>::value + ... + 0)> out{};
+    size_t n = 0;
+
+    (append(out, n, Layouts::inputs), ...);
+
+    return out;
+}
+
+constexpr bool overlaps(const ShaderInputInfo& a, const ShaderInputInfo& b) {
+    return a.location < b.location + b.locations && b.location < a.location + a.locations;
+}
+
+}  // namespace vertex_layout_detail
+
+// Vertex type V fetched from one binding.
+template <typename V, uint32_t Binding, vk::VertexInputRate Rate, typename... Attributes>
+struct VertexLayout {
+    static constexpr uint32_t binding = Binding;
+    static constexpr size_t attributeCount = (Attributes::Traits::locations + ... + 0);
+
+    static constexpr std::array<VertexAttributeInfo, sizeof...(Attributes)> attributes = {Attributes::attribute...};
+    static constexpr std::array<ShaderInputInfo, sizeof...(Attributes)> inputs = {Attributes::input...};
+
+    static constexpr vk::VertexInputBindingDescription bindingDescription =
+        vk::VertexInputBindingDescription(Binding, sizeof(V), Rate);
+
+    static constexpr std::array<vk::VertexInputAttributeDescription, attributeCount> attributeDescriptions =
+        vertex_layout_detail::buildAttributes<attributeCount>(Binding, attributes.data(), attributes.size());
+};
+
+// A shader's vertex inputs, written down next to the layouts that feed it.
+template <typename... Inputs>
+struct ShaderInputs {
+    static constexpr std::array<ShaderInputInfo, sizeof...(Inputs)> inputs = {Inputs::input...};
+
+    // Every shader input is fed by exactly one attribute of the same shape, and no two attributes share a location.
+    // Attributes the shader doesn't read are fine.
+    template <typename... Layouts>
+    static constexpr bool matches() {
+        constexpr auto provided = vertex_layout_detail::gatherInputs<Layouts...>();
+
+        for (size_t i = 0; i < provided.size(); i++) {
+            for (size_t j = i + 1; j < provided.size(); j++) {
+                if (vertex_layout_detail::overlaps(provided[i], provided[j])) {
+                    return false;
+                }
+            }
+        }
+
+        for (const ShaderInputInfo& in : inputs) {
+            bool found = false;
+
+            for (const ShaderInputInfo& p : provided) {
+                if (!vertex_layout_detail::overlaps(in, p)) {
+                    continue;
+                }
+
+                if (p.location != in.location || p.locations != in.locations || p.components != in.components ||
+                    p.integer != in.integer) {
+                    return false;
+                }
+
+                found = true;
+            }
+
+            if (!found) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+#endif
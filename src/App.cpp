@@ -1,5 +1,9 @@
 #include "App.hpp"
 
+#include <chrono>
+
+#include "Trace.hpp"
+
 // Custom Debug Callback
 static VkBool32 debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
                               VkDebugUtilsMessageTypeFlagsEXT type,
@@ -71,18 +75,47 @@ static void glfwFramebufferResizeCallback(GLFWwindow* window, int width, int hei
     app->glfwFramebufferResized = true;
 }
 
-bool App::init() {
-    if (!glfwInit()) {
-        std::cerr << "Could not initialize GLFW!\n";
+static void glfwKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    // Dump whatever the trace buffers currently hold, so hitches can be looked at right after they happen.
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS) {
+        if (!Trace::enabled()) {
+            logInfo("Tracing is off, start with --trace to record");
+        } else if (Trace::dumpChromeJson("atom3d_trace.json")) {
+            logInfo("Wrote atom3d_trace.json");
+        }
+    }
+}
+
+bool App::init(const AppSettings& settings) {
+    m_settings = settings;
+
+    Trace::setThreadName("main");
+
+    // Zero sized images (headless targets) and windows are invalid
+    if (m_settings.width == 0 || m_settings.height == 0) {
+        logError("Width and height have to be at least 1.");
         return false;
     }
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
-    m_glfwWindow = glfwCreateWindow(800, 600, "Atom3D", nullptr, nullptr);
+    // The scene's vertex format decides the pipeline's vertex input, so it has to exist before that
+    if (!m_scene) {
+        m_scene = std::make_unique<MainScene>();
+    }
+
+    if (!m_settings.headless) {
+        if (!glfwInit()) {
+            std::cerr << "Could not initialize GLFW!\n";
+            return false;
+        }
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+        m_glfwWindow = glfwCreateWindow(m_settings.width, m_settings.height, "Atom3D", nullptr, nullptr);
 
-    glfwSetWindowUserPointer(m_glfwWindow, this);
-    glfwSetFramebufferSizeCallback(m_glfwWindow, glfwFramebufferResizeCallback);
+        glfwSetWindowUserPointer(m_glfwWindow, this);
+        glfwSetFramebufferSizeCallback(m_glfwWindow, glfwFramebufferResizeCallback);
+        glfwSetKeyCallback(m_glfwWindow, glfwKeyCallback);
+    }
 
     const std::vector<const char*> instance_extensions = {VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME};
 
@@ -95,6 +128,7 @@ bool App::init() {
                        .set_debug_messenger_severity(debug_severity)
                        .set_debug_messenger_type(debug_types)
                        .enable_extensions(instance_extensions)
+                       .set_headless(m_settings.headless)
                        .build();
 
     if (!instRet) {
@@ -106,27 +140,52 @@ bool App::init() {
     m_instance = m_vkbInstance;
 
     // Surface Creation
-    VkSurfaceKHR tmpSurface = VK_NULL_HANDLE;
-    VkResult glfwRet = glfwCreateWindowSurface(m_vkbInstance, m_glfwWindow, nullptr, &tmpSurface);
+    if (!m_settings.headless) {
+        VkSurfaceKHR tmpSurface = VK_NULL_HANDLE;
+        VkResult glfwRet = glfwCreateWindowSurface(m_vkbInstance, m_glfwWindow, nullptr, &tmpSurface);
 
-    if (glfwRet != VK_SUCCESS) {
-        std::cerr << "Error creating window surface!\n";
-        return false;
-    }
+        if (glfwRet != VK_SUCCESS) {
+            std::cerr << "Error creating window surface!\n";
+            return false;
+        }
 
-    m_surface = tmpSurface;
+        m_surface = tmpSurface;
+    }
 
     vk::PhysicalDeviceVulkan12Features pd12Features;
     pd12Features.bufferDeviceAddress = true;
+    pd12Features.drawIndirectCount = true;
+    pd12Features.timelineSemaphore = true;
+
+    // Bindless set, see Bindless.hpp. Materials index textures per fragment, so non uniform indexing too.
+    pd12Features.runtimeDescriptorArray = true;
+    pd12Features.descriptorBindingPartiallyBound = true;
+    pd12Features.descriptorBindingSampledImageUpdateAfterBind = true;
+    pd12Features.descriptorBindingStorageBufferUpdateAfterBind = true;
+    pd12Features.descriptorBindingUpdateUnusedWhilePending = true;
+    pd12Features.shaderSampledImageArrayNonUniformIndexing = true;
+
+    // Whole scene goes out as one multi draw indirect, firstInstance points at each batch's instances.
+    vk::PhysicalDeviceFeatures pdFeatures;
+    pdFeatures.multiDrawIndirect = true;
+    pdFeatures.drawIndirectFirstInstance = true;
 
     vkb::PhysicalDeviceSelector selector(m_vkbInstance);
+    selector.set_required_features(pdFeatures);
     selector.set_required_features_12(pd12Features);
 
 #if defined(ATOM3D_USE_VK_DYNAMIC_RENDERING)
     selector.add_required_extension_features(vk::PhysicalDeviceDynamicRenderingFeatures(1));
 #endif
 
-    auto physRet = selector.set_surface(m_surface).select();
+    if (m_settings.headless) {
+        // Software ICDs (lavapipe, swiftshader) tend to lag behind on API version, 1.2 is all we actually use.
+        selector.set_minimum_version(1, 2);
+    } else {
+        selector.set_surface(m_surface);
+    }
+
+    auto physRet = selector.select();
 
     if (!physRet) {
         std::cerr << "Failed to select physical device: " << physRet.error().message() << "\n";
@@ -158,30 +217,103 @@ bool App::init() {
 
     m_vmaBudgets = m_vmaAllocator.getHeapBudgets();
 
-    if (!createSwapchain()) {
-        return false;
+    if (m_settings.headless) {
+        if (!createOffscreenTargets()) {
+            return false;
+        }
+    } else {
+        if (!createSwapchain()) {
+            return false;
+        }
+
+        if (!createSwapchainImageViews()) {
+            return false;
+        }
     }
 
-    if (!createSwapchainImageViews()) {
+    if (!getQueues()) {
         return false;
     }
 
-    if (!getQueues()) {
+    if (!m_transfer.init(m_device, m_vkbDevice, m_vmaAllocator)) {
         return false;
     }
 
+    if (!m_transfer.dedicated()) {
+        logWarning("No separate transfer queue family, uploads share the graphics queue.");
+    }
+
 #if !defined(ATOM3D_USE_VK_DYNAMIC_RENDERING)
     createRenderPass();
     createFramebuffers();
 #endif
 
-    createGraphicsPipeline();
+    m_pipelineCache.init(m_device, vk::PhysicalDeviceProperties(m_vkbPD.properties), m_settings.pipelineCachePath);
+
+    if (m_pipelineCache.loadedSize() > 0) {
+        logInfo("Loaded " + std::to_string(m_pipelineCache.loadedSize()) + " bytes of pipeline cache from " + m_settings.pipelineCachePath);
+    }
+
+    // Every set layout comes from here, so it goes first
+    m_pipelines.init(m_device, m_pipelineCache.cache());
+
+    if (!m_frameAllocator.init(m_device, m_pipelines, m_vmaAllocator, vk::PhysicalDeviceLimits(m_vkbPD.properties.limits), MAX_FRAMES_IN_FLIGHT)) {
+        return false;
+    }
+
+    if (!m_bindless.init(m_device, m_vkbPD.physical_device, m_pipelines, m_vmaAllocator)) {
+        return false;
+    }
+
+    m_shaders.init(m_settings.shaderDir);
+    m_compiler.init(m_pipelines);
+
+    // Compiled on the compiler's threads while the rest of init (scene upload mostly) runs
+    createGraphicsPipelineLayout();
+
+    std::future<vk::Pipeline> scenePipeline = queueScenePipeline(CompilePriority::Critical);
+    std::future<vk::Pipeline> cullingPipeline = queueCullingPipeline(CompilePriority::Critical);
+
     createCommandPool();
     createCommandBuffers();
     createSyncObjects();
 
+    m_recorder.init(m_device, m_vkbDevice.get_queue_index(vkb::QueueType::graphics).value(), m_settings.recordThreads, MAX_FRAMES_IN_FLIGHT);
+
+    if (m_recorder.threadCount() > 1) {
+        logInfo("Recording the scene pass on " + std::to_string(m_recorder.threadCount()) + " threads.");
+    }
+
+    // Default texture has to be ready before anything samples it
+    m_mainCommandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    m_bindless.recordDefaults(m_mainCommandBuffer);
+    m_mainCommandBuffer.end();
+
+    submitAndWait(m_mainCommandBuffer);
+
+    // Only loose files can change, the embedded ones are fixed
+    if (!m_settings.headless && m_settings.shaderHotReload && !m_shaders.overrideDir().empty() &&
+        !m_shaderWatcher.init(m_shaders.overrideDir())) {
+        logWarning("Shader hot reload unavailable.");
+    }
+
+    if (!m_gpuProfiler.init(m_device, m_vkbPD, m_vkbDevice.get_queue_index(vkb::QueueType::graphics).value(), MAX_FRAMES_IN_FLIGHT)) {
+        logWarning("Timestamp queries unsupported on the graphics queue, GPU timings will not be reported.");
+    }
+
     setupScene();
 
+    m_graphicsPipeline = scenePipeline.get();
+
+    if (!m_graphicsPipeline) {
+        std::cerr << "Failed to create the scene pipeline.\n";
+        return false;
+    }
+
+    if (!createCullingPass(cullingPipeline.get())) {
+        return false;
+    }
+
     return true;
 }
 
@@ -197,6 +329,11 @@ bool App::createSwapchain() {
     m_vkbSwapchain = swap_ret.value();
     m_swapchain = m_vkbSwapchain.swapchain;
 
+    m_renderExtent = m_vkbSwapchain.extent;
+    m_scene->resize(m_renderExtent.width, m_renderExtent.height);
+    m_colorFormat = static_cast<vk::Format>(m_vkbSwapchain.image_format);
+    m_colorFinalLayout = vk::ImageLayout::ePresentSrcKHR;
+
     return true;
 }
 
@@ -226,6 +363,8 @@ bool App::createSwapchainImageViews() {
 }
 
 bool App::recreateSwapchain() {
+    ATOM3D_TRACE_SCOPE("recreateSwapchain");
+
     m_device.waitIdle();
 
     cleanupSwapchain();
@@ -250,6 +389,11 @@ void App::cleanupSwapchain() {
     m_device.freeCommandBuffers(m_commandPool, m_commandBuffers);
     m_device.destroyCommandPool(m_commandPool);
 
+    if (m_settings.headless) {
+        destroyOffscreenTargets();
+        return;
+    }
+
     m_vkbSwapchain.destroy_image_views(m_swapchainImageViews);
 
     m_swapchain = VK_NULL_HANDLE;
@@ -257,6 +401,47 @@ void App::cleanupSwapchain() {
     vkb::destroy_swapchain(m_vkbSwapchain);
 }
 
+bool App::createOffscreenTargets() {
+    m_renderExtent = vk::Extent2D(m_settings.width, m_settings.height);
+    m_scene->resize(m_renderExtent.width, m_renderExtent.height);
+    m_colorFormat = vk::Format::eR8G8B8A8Unorm;
+    // Nothing to present to, leave the image ready to be copied out by saveFrame().
+    m_colorFinalLayout = vk::ImageLayout::eTransferSrcOptimal;
+
+    m_offscreenImages.clear();
+    m_swapchainImages.clear();
+    m_swapchainImageViews.clear();
+
+    vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        AllocatedImage img = AllocatedImage::createImage(m_vmaAllocator, m_device, m_renderExtent, m_colorFormat, usage);
+
+        if (!img.image || !img.view) {
+            std::cerr << "Failed to create offscreen render target!\n";
+            return false;
+        }
+
+        m_offscreenImages.push_back(img);
+
+        // The rest of the renderer only knows about "swapchain" images, so just hand it ours.
+        m_swapchainImages.push_back(img.image);
+        m_swapchainImageViews.push_back(img.view);
+    }
+
+    return true;
+}
+
+void App::destroyOffscreenTargets() {
+    for (auto& img : m_offscreenImages) {
+        AllocatedImage::destroyImage(m_vmaAllocator, m_device, img);
+    }
+
+    m_offscreenImages.clear();
+    m_swapchainImages.clear();
+    m_swapchainImageViews.clear();
+}
+
 bool App::getQueues() {
     auto gq = m_vkbDevice.get_queue(vkb::QueueType::graphics);
     if (!gq) {
@@ -266,6 +451,10 @@ bool App::getQueues() {
 
     m_graphicsQueue = gq.value();
 
+    if (m_settings.headless) {
+        return true;
+    }
+
     auto pq = m_vkbDevice.get_queue(vkb::QueueType::present);
     if (!pq) {
         std::cerr << "Failed to acquire present queue: " << pq.error().message() << "\n";
@@ -279,50 +468,40 @@ bool App::getQueues() {
 
 void App::createRenderPass() {
     vk::AttachmentDescription colorAttachment;
-    colorAttachment.setFormat(static_cast<vk::Format>(m_vkbSwapchain.image_format))
+    colorAttachment.setFormat(m_colorFormat)
         .setLoadOp(vk::AttachmentLoadOp::eClear)
         .setStoreOp(vk::AttachmentStoreOp::eStore)
         .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
         .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
         .setInitialLayout(vk::ImageLayout::eUndefined)
-        .setFinalLayout(vk::ImageLayout::ePresentSrcKHR);
+        .setFinalLayout(m_colorFinalLayout);
 
     vk::AttachmentReference colorRef(0, vk::ImageLayout::eColorAttachmentOptimal);
 
     vk::SubpassDescription subpass({}, vk::PipelineBindPoint::eGraphics, {}, colorRef);
 
-    vk::SubpassDependency dep(vk::SubpassExternal, 0, vk::PipelineStageFlagBits::eColorAttachmentOutput,
-                              vk::PipelineStageFlagBits::eColorAttachmentOutput,
-                              vk::AccessFlagBits::eNone,
-                              vk::AccessFlagBits::eColorAttachmentWrite);
+    std::vector<vk::SubpassDependency> deps;
+    deps.push_back(vk::SubpassDependency(vk::SubpassExternal, 0, vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                         vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                         vk::AccessFlagBits::eNone,
+                                         vk::AccessFlagBits::eColorAttachmentWrite));
+
+    // saveFrame() copies the image out in a submission of its own, queue order alone doesn't make the writes visible
+    if (m_colorFinalLayout == vk::ImageLayout::eTransferSrcOptimal) {
+        deps.push_back(vk::SubpassDependency(0, vk::SubpassExternal, vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                             vk::PipelineStageFlagBits::eTransfer,
+                                             vk::AccessFlagBits::eColorAttachmentWrite,
+                                             vk::AccessFlagBits::eTransferRead));
+    }
 
     vk::RenderPassCreateInfo renderPassInfo(vk::RenderPassCreateFlags(),
                                             1, &colorAttachment,
                                             1, &subpass,
-                                            1, &dep);
+                                            static_cast<uint32_t>(deps.size()), deps.data());
 
     m_renderPass = m_device.createRenderPass(renderPassInfo);
 }
 
-std::vector<char> App::loadSPV(const std::string& filename) {
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open()) {
-        std::cerr << "Failed to open shader " << filename << "\n";
-        throw std::runtime_error("oop");
-    }
-
-    size_t fileSize = (size_t)file.tellg();
-    std::vector<char> buf(fileSize);
-
-    file.seekg(0);
-    file.read(buf.data(), fileSize);
-
-    file.close();
-
-    return buf;
-}
-
 vk::ShaderModule App::createShaderModule(const std::vector<char>& code) {
     vk::ShaderModuleCreateInfo info(vk::ShaderModuleCreateFlagBits(),
                                     code.size(),
@@ -331,113 +510,167 @@ vk::ShaderModule App::createShaderModule(const std::vector<char>& code) {
     return m_device.createShaderModule(info);
 }
 
-bool App::createGraphicsPipeline() {
-    // Shaders
-    auto vertCode = loadSPV("../src/shaders/vert.spv");
-    auto fragCode = loadSPV("../src/shaders/frag.spv");
+void App::createGraphicsPipelineLayout() {
+    // Set 0 is the frame allocator, camera on its dynamic uniform binding. Set 1 is the bindless set, the push
+    // constants say where in it the materials are and where vertex pulling finds its buffers.
+    PipelineLayoutDesc layoutDesc;
+    layoutDesc.addSetLayout(m_frameAllocator.setLayout())
+        .addSetLayout(m_bindless.setLayout())
+        .addPushConstants(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(ScenePushConstants));
 
-    auto vertModule = createShaderModule(vertCode);
-    auto fragModule = createShaderModule(fragCode);
+    m_pipelineLayout = m_pipelines.pipelineLayout(layoutDesc);
+}
 
-    if (vertModule == VK_NULL_HANDLE || fragModule == VK_NULL_HANDLE) {
-        std::cerr << "Failed to create shader module";
-        return false;
-    }
+std::future<vk::Pipeline> App::queueScenePipeline(CompilePriority priority) {
+    ScenePipelineState state;
+    state.vertexFormat = m_scene->vertexFormat;
+    state.colorFormat = m_colorFormat;
+    state.renderPass = m_renderPass;
 
-    vk::PipelineShaderStageCreateInfo vertInfo({}, vk::ShaderStageFlagBits::eVertex, vertModule, "main");
-    vk::PipelineShaderStageCreateInfo fragInfo({}, vk::ShaderStageFlagBits::eFragment, fragModule, "main");
+    // Shaders are loaded on the compiler thread as well, the override directory's may need reading
+    return m_compiler.submit([this, state, vertName = sceneVertexShader()]() -> vk::Pipeline {
+        ATOM3D_TRACE_SCOPE("buildScenePipeline");
 
-    std::vector<vk::PipelineShaderStageCreateInfo> shaderStages = {vertInfo, fragInfo};
+        std::vector<char> vertCode, fragCode;
 
-    // Input States
-    auto binding = Vertex::getBindingDescription();
-    auto attrDesc = Vertex::getAttrDesc();
+        if (!m_shaders.load(vertName, vertCode) || !m_shaders.load("frag.spv", fragCode)) {
+            std::cerr << "Failed to read the scene shaders.\n";
+            return VK_NULL_HANDLE;
+        }
 
-    vk::PipelineVertexInputStateCreateInfo vertexInputInfo({}, binding, attrDesc);
+        // Broken shaders come back as VK_NULL_HANDLE
+        return m_pipelines.graphicsPipeline(scenePipelineDesc(state, vertCode, fragCode));
+    }, priority);
+}
 
-    vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo({}, vk::PrimitiveTopology::eTriangleList, false);
+std::future<vk::Pipeline> App::queueCullingPipeline(CompilePriority priority) {
+    return m_compiler.submit([this]() -> vk::Pipeline {
+        ATOM3D_TRACE_SCOPE("buildCullingPipeline");
 
-    // viewport stuff
-    vk::Viewport viewport(0, 0,
-                          (float)m_vkbSwapchain.extent.width,
-                          (float)m_vkbSwapchain.extent.height,
-                          0.0, 1.0);
+        std::vector<char> cullCode;
 
-    vk::Rect2D scissor({0, 0}, m_vkbSwapchain.extent);
+        if (!m_shaders.load("cull.spv", cullCode)) {
+            std::cerr << "Failed to read the culling shader.\n";
+            return VK_NULL_HANDLE;
+        }
 
-    vk::PipelineViewportStateCreateInfo viewportInfo({}, viewport, scissor);
+        return m_pipelines.computePipeline(GpuCulling::pipelineDesc(m_pipelines, cullCode));
+    }, priority);
+}
 
-    // Rasterizer
-    vk::PipelineRasterizationStateCreateInfo rasterizer({}, false, false,
-                                                        vk::PolygonMode::eFill,
-                                                        vk::CullModeFlagBits::eBack,
-                                                        vk::FrontFace::eClockwise,
-                                                        false, 0.0, 0.0, 0.0, 1.0);
+/// @brief Describes the scene pass' pipeline around the given shaders. Called from the pipeline compiler's threads,
+/// so apart from state it only reads members that are fixed once init() created the pipeline layout.
+GraphicsPipelineDesc App::scenePipelineDesc(const ScenePipelineState& state, const std::vector<char>& vertCode,
+                                            const std::vector<char>& fragCode) const {
+    GraphicsPipelineDesc desc;
+    desc.addStage(vk::ShaderStageFlagBits::eVertex, vertCode)
+        .addStage(vk::ShaderStageFlagBits::eFragment, fragCode)
+        .setRasterizer(vk::PolygonMode::eFill, vk::CullModeFlagBits::eBack, vk::FrontFace::eClockwise)
+        .setLayout(m_pipelineLayout);
+
+    const VertexFormat vertexFormat = state.vertexFormat;
+
+    // Input States, per vertex on binding 0 and per instance on binding 1. None with vertex pulling, its shader is
+    // specialized for the vertex format instead.
+    if (m_settings.vertexPulling) {
+        desc.setConstant(vk::ShaderStageFlagBits::eVertex, SPEC_VERTEX_FORMAT, static_cast<uint32_t>(vertexFormat));
+    } else {
+        std::vector<vk::VertexInputBindingDescription> bindings = {Vertex::getBindingDescription(vertexFormat),
+                                                                   InstanceVertex::getBindingDescription()};
+        std::vector<vk::VertexInputAttributeDescription> attrDesc;
+
+        for (auto& a : Vertex::getAttrDesc(vertexFormat)) attrDesc.push_back(a);
+        for (auto& a : InstanceVertex::getAttrDesc()) attrDesc.push_back(a);
+
+        desc.setVertexInput(std::move(bindings), std::move(attrDesc));
+    }
 
-    // MultiSampling
-    vk::PipelineMultisampleStateCreateInfo multisampling;
+#if defined(ATOM3D_USE_VK_DYNAMIC_RENDERING)
+    desc.setColorFormat(state.colorFormat);
+#else
+    desc.setRenderPass(state.renderPass);
+#endif
 
-    // Color Blending
-    vk::PipelineColorBlendAttachmentState colorblendAttachment;
-    colorblendAttachment.colorWriteMask = vk::FlagTraits<vk::ColorComponentFlagBits>::allFlags;
-    colorblendAttachment.blendEnable = false;
+    return desc;
+}
 
-    vk::PipelineColorBlendStateCreateInfo colorblendInfo;
-    colorblendInfo.setLogicOpEnable(false)
-        .setLogicOp(vk::LogicOp::eCopy)
-        .setAttachmentCount(1)
-        .setPAttachments(&colorblendAttachment);
+std::string App::sceneVertexShader() const {
+    // Vertex pulling fetches everything itself
+    return m_settings.vertexPulling ? "vert_pull.spv" : "vert.spv";
+}
 
-    // Layout
-    vk::PipelineLayoutCreateInfo layoutInfo;
+bool App::createCullingPass(vk::Pipeline pipeline) {
+    bool ok = m_culling.init(m_device, m_pipelines, *m_scene, pipeline);
+    m_culling.setFrustumCulling(m_settings.gpuCulling);
+    m_culling.setLodThreshold(m_settings.lodThresholdPixels);
 
-    m_pipelineLayout = m_device.createPipelineLayout(layoutInfo);
+    return ok;
+}
 
-    std::vector<vk::DynamicState> dynStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+static bool isReady(const std::future<vk::Pipeline>& f) {
+    return f.valid() && f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
 
-    vk::PipelineDynamicStateCreateInfo dynamicInfo({}, dynStates);
+void App::retirePipeline(vk::Pipeline pipeline) {
+    // Out of the cache right away so nothing picks it up again, destroyed once no frame in flight uses it
+    m_pipelines.release(pipeline);
+    deferDeletion([device = m_device, pipeline]() { device.destroyPipeline(pipeline); });
+}
 
-#if defined(ATOM3D_USE_VK_DYNAMIC_RENDERING)
-    vk::Format formats = { static_cast<vk::Format>(m_vkbSwapchain.image_format) };
-    vk::PipelineRenderingCreateInfo renderingCreateInfo;
-    renderingCreateInfo.setColorAttachmentCount(1)
-        .setColorAttachmentFormats(formats);
-#endif
+void App::updateShaderReload() {
+    if (!m_shaderWatcher.active()) {
+        return;
+    }
 
-    // Pipeline
-    vk::GraphicsPipelineCreateInfo pipeInfo;
-    pipeInfo.setStageCount(2)
-        .setStages(shaderStages)
-        .setPVertexInputState(&vertexInputInfo)
-        .setPInputAssemblyState(&inputAssemblyInfo)
-        .setPViewportState(&viewportInfo)
+    ATOM3D_TRACE_SCOPE("updateShaderReload");
 
-#if defined(ATOM3D_USE_VK_DYNAMIC_RENDERING)
-        .setPNext(&renderingCreateInfo)
-#else
-        .setRenderPass(m_renderPass)
-#endif
+    for (const std::string& name : m_shaderWatcher.poll()) {
+        if (name == sceneVertexShader() || name == "frag.spv") {
+            m_graphicsShadersChanged = true;
+        } else if (name == "cull.spv") {
+            m_cullShaderChanged = true;
+        }
+    }
 
-        .setPRasterizationState(&rasterizer)
-        .setPMultisampleState(&multisampling)
-        .setPColorBlendState(&colorblendInfo)
-        .setPDynamicState(&dynamicInfo)
-        .setLayout(m_pipelineLayout)
-        .setSubpass(0);
+    // Nothing of this frame is recorded yet, so it's the first one to use a new pipeline. Frames still in flight
+    // keep using the old one, it goes away once the last of them is done.
+    if (isReady(m_graphicsReload)) {
+        vk::Pipeline pipeline = m_graphicsReload.get();
 
-    auto tmp = m_device.createGraphicsPipeline(VK_NULL_HANDLE, pipeInfo);
+        // The same pipeline back means the shaders were written again without changing
+        if (!pipeline) {
+            logWarning("Failed to rebuild the scene pipeline, keeping the old one.");
+        } else if (pipeline != m_graphicsPipeline) {
+            vk::Pipeline old = m_graphicsPipeline;
+            m_graphicsPipeline = pipeline;
 
-    if (tmp.result != vk::Result::eSuccess) {
-        std::cerr << "Failed to create graphics pipeline.";
-        return false;
+            retirePipeline(old);
+            logInfo("Reloaded scene shaders.");
+        }
     }
 
-    m_graphicsPipeline = tmp.value;
+    if (isReady(m_cullingReload)) {
+        vk::Pipeline pipeline = m_cullingReload.get();
 
-    m_device.destroyShaderModule(vertModule);
-    m_device.destroyShaderModule(fragModule);
+        if (!pipeline) {
+            logWarning("Failed to rebuild the culling pipeline, keeping the old one.");
+        } else if (pipeline != m_culling.pipeline()) {
+            retirePipeline(m_culling.swapPipeline(pipeline));
+            logInfo("Reloaded culling shader.");
+        }
+    }
 
-    return true;
+    // One rebuild per pipeline at a time, changes during a rebuild start the next one after it. Deferred, nothing
+    // waits on them.
+    if (m_graphicsShadersChanged && !m_graphicsReload.valid()) {
+        m_graphicsShadersChanged = false;
+        m_graphicsReload = queueScenePipeline(CompilePriority::Deferred);
+    }
+
+    if (m_cullShaderChanged && !m_cullingReload.valid()) {
+        m_cullShaderChanged = false;
+        m_cullingReload = queueCullingPipeline(CompilePriority::Deferred);
+    }
 }
 
 bool App::createFramebuffers() {
@@ -451,8 +684,8 @@ bool App::createFramebuffers() {
         info.setRenderPass(m_renderPass)
             .setAttachmentCount(1)
             .setAttachments(iv)
-            .setWidth(m_vkbSwapchain.extent.width)
-            .setHeight(m_vkbSwapchain.extent.height)
+            .setWidth(m_renderExtent.width)
+            .setHeight(m_renderExtent.height)
             .setLayers(1);
 
         m_framebuffers.push_back(m_device.createFramebuffer(info));
@@ -474,6 +707,7 @@ void App::createCommandBuffers() {
 
     m_mainCommandBuffer = tmp[0];
     m_commandBuffers = std::vector<vk::CommandBuffer>(tmp.begin() + 1, tmp.end());
+    m_commandBufferValues.assign(m_commandBuffers.size(), 0);
 
     // This is done in drawFrame() now !!!!!
     // vk::CommandBufferBeginInfo beginInfo;
@@ -504,20 +738,19 @@ void App::createCommandBuffers() {
 }
 
 void App::createSyncObjects() {
+    // Acquire and present only take binary semaphores, everything else goes through the frame timeline.
     m_imageAvailableSems.resize(MAX_FRAMES_IN_FLIGHT);
     m_renderFinishedSems.resize(MAX_FRAMES_IN_FLIGHT);
-    m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    m_imageInFlightFences.resize(m_vkbSwapchain.image_count, VK_NULL_HANDLE);
 
     vk::SemaphoreCreateInfo semInfo;
 
-    vk::FenceCreateInfo fenceInfo(vk::FenceCreateFlagBits::eSignaled);
-
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         m_imageAvailableSems[i] = m_device.createSemaphore(semInfo);
         m_renderFinishedSems[i] = m_device.createSemaphore(semInfo);
-        m_inFlightFences[i] = m_device.createFence(fenceInfo);
     }
+
+    m_frameTimeline.init(m_device);
+    m_frameSlotValues.fill(0);
 }
 
 void App::destroySyncObjects() {
@@ -527,19 +760,11 @@ void App::destroySyncObjects() {
     for (auto& s : m_renderFinishedSems)
         m_device.destroySemaphore(s);
 
-    for (auto& f : m_inFlightFences)
-        m_device.destroyFence(f);
+    m_frameTimeline.destroy();
 }
 
 void App::recordDrawCommandsScene(vk::CommandBuffer cb, uint32_t image, Scene* scene) {
-    vk::Viewport viewport((0.0), (0.0), 
-                          m_vkbSwapchain.extent.width, 
-                          m_vkbSwapchain.extent.height, 
-                          0, 1);
-
-    vk::Rect2D scissor({0, 0}, m_vkbSwapchain.extent);
-    cb.setViewport(0, viewport);
-    cb.setScissor(0, scissor);
+    ATOM3D_TRACE_SCOPE("recordDrawCommandsScene");
 
     vk::ClearColorValue val(1.f, 0.5f, 0.2f, 1.f);
 
@@ -553,6 +778,9 @@ void App::recordDrawCommandsScene(vk::CommandBuffer cb, uint32_t image, Scene* s
         .setBaseArrayLayer(0)
         .setLayerCount(vk::RemainingArrayLayers);
 
+    // Chunks recorded on the recorder's threads, only secondaries inside the pass then
+    const bool secondaries = m_recorder.threadCount() > 1 && scene->drawChunks.size() > 1;
+
 #if defined(ATOM3D_USE_VK_DYNAMIC_RENDERING)
     // Transition Image Layout to ColorAttachmentOptimal
     
@@ -578,100 +806,289 @@ void App::recordDrawCommandsScene(vk::CommandBuffer cb, uint32_t image, Scene* s
         .setLoadOp(vk::AttachmentLoadOp::eClear)
         .setStoreOp(vk::AttachmentStoreOp::eStore);
 
-    vk::Rect2D renderArea({ 0, 0 }, {m_vkbSwapchain.extent.width, m_vkbSwapchain.extent.height});
+    vk::Rect2D renderArea({ 0, 0 }, {m_renderExtent.width, m_renderExtent.height});
 
     vk::RenderingInfo renderInfo;
     renderInfo.setColorAttachments(colorInfo)
         .setRenderArea(renderArea)
         .setLayerCount(1);
 
+    if (secondaries) {
+        renderInfo.setFlags(vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+    }
+
+    uint32_t sceneScope = m_gpuProfiler.beginScope(cb, "scene");
+
     cb.beginRendering(renderInfo);
 #else
     vk::RenderPassBeginInfo rpInfo;
     rpInfo.renderPass = m_renderPass;
     rpInfo.framebuffer = m_framebuffers[image];
-    rpInfo.renderArea.extent = m_vkbSwapchain.extent;
+    rpInfo.renderArea.extent = m_renderExtent;
     rpInfo.setClearValueCount(1);
     rpInfo.setClearValues(clearVal);
 
-    cb.beginRenderPass(rpInfo, vk::SubpassContents::eInline);
+    uint32_t sceneScope = m_gpuProfiler.beginScope(cb, "scene");
+
+    cb.beginRenderPass(rpInfo, secondaries ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline);
 #endif
 
-    cb.bindPipeline(vk::PipelineBindPoint::eGraphics, m_graphicsPipeline);
+    CameraUbo camera;
+    camera.view = scene->camera.view;
+    camera.projection = scene->camera.projection;
+    camera.viewProjection = scene->camera.viewProjection();
+
+    // Uniform binding gets the camera, the storage binding isn't used by the scene pass yet. Pushed once, every
+    // chunk binds the same offsets. If the frame allocator is full (it reports that itself) nothing is drawn.
+    std::optional<uint32_t> cameraOffset = m_frameAllocator.pushUniform(camera);
+    std::array<uint32_t, 2> dynamicOffsets = {cameraOffset.value_or(0), 0};
+
+    if (!cameraOffset) {
+        // The pass still clears, just without any draws
+    } else if (secondaries) {
+        // Secondaries don't inherit any state but the pass they're in
+#if defined(ATOM3D_USE_VK_DYNAMIC_RENDERING)
+        vk::CommandBufferInheritanceRenderingInfo renderingInheritance;
+        renderingInheritance.setColorAttachmentFormats(m_colorFormat)
+            .setRasterizationSamples(vk::SampleCountFlagBits::e1);
+
+        vk::CommandBufferInheritanceInfo inheritance;
+        inheritance.setPNext(&renderingInheritance);
+#else
+        vk::CommandBufferInheritanceInfo inheritance(m_renderPass, 0, m_framebuffers[image]);
+#endif
 
-    vk::DeviceSize offsets[] = {0};
-    vk::Buffer buffers[] = {m_scene.buffer.buffer};
-    cb.bindVertexBuffers(0, 1, buffers, offsets);
+        const auto& chunks = m_recorder.record(m_currentFrame, inheritance, static_cast<uint32_t>(scene->drawChunks.size()),
+                                               [&](vk::CommandBuffer chunkCb, uint32_t chunk) {
+                                                   recordSceneChunk(chunkCb, *scene, chunk, dynamicOffsets);
+                                               });
 
-    cb.draw(3, 1, 0, 0);
+        cb.executeCommands(chunks);
+    } else {
+        for (uint32_t chunk = 0; chunk < scene->drawChunks.size(); chunk++) {
+            recordSceneChunk(cb, *scene, chunk, dynamicOffsets);
+        }
+    }
 
 #if defined(ATOM3D_USE_VK_DYNAMIC_RENDERING)
     cb.endRendering();
 
+    m_gpuProfiler.endScope(cb, sceneScope);
+
+    // Headless frames are copied out by saveFrame() afterwards, that copy has to see the writes
+    const bool toTransfer = m_colorFinalLayout == vk::ImageLayout::eTransferSrcOptimal;
+
     barrier.setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eColorAttachmentRead)
-        .setDstAccessMask(vk::AccessFlagBits::eNone)
+        .setDstAccessMask(toTransfer ? vk::AccessFlagBits::eTransferRead : vk::AccessFlagBits::eNone)
         .setOldLayout(vk::ImageLayout::eColorAttachmentOptimal)
-        .setNewLayout(vk::ImageLayout::ePresentSrcKHR)
+        .setNewLayout(m_colorFinalLayout)
         .setImage(m_swapchainImages[image])
         .setSubresourceRange(range);
 
-    cb.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eColorAttachmentOutput, {}, nullptr, nullptr, barrier);
+    cb.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                       toTransfer ? vk::PipelineStageFlagBits::eTransfer : vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                       {}, nullptr, nullptr, barrier);
 #else
     cb.endRenderPass();
+
+    m_gpuProfiler.endScope(cb, sceneScope);
 #endif
 }
 
+/// @brief Everything one draw chunk needs, from viewport to its draw. Runs on the recorder's threads as well, so it
+/// only reads state that's fixed while a frame is recorded.
+void App::recordSceneChunk(vk::CommandBuffer cb, const Scene& scene, uint32_t chunk, const std::array<uint32_t, 2>& dynamicOffsets) const {
+    vk::Viewport viewport((0.0), (0.0), 
+                          m_renderExtent.width, 
+                          m_renderExtent.height, 
+                          0, 1);
+
+    vk::Rect2D scissor({0, 0}, m_renderExtent);
+    cb.setViewport(0, viewport);
+    cb.setScissor(0, scissor);
+
+    cb.bindPipeline(vk::PipelineBindPoint::eGraphics, m_graphicsPipeline);
+
+    std::array<vk::DescriptorSet, 2> sets = {m_frameAllocator.descriptorSet(), m_bindless.descriptorSet()};
+    cb.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 0, sets, dynamicOffsets);
+
+    cb.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0,
+                     sizeof(ScenePushConstants), &m_scenePush);
+
+    // Indices still go through the index buffer, vertex pulling reads the rest through the push constant addresses
+    if (!m_settings.vertexPulling) {
+        vk::DeviceSize offsets[] = {0, 0};
+        vk::Buffer buffers[] = {scene.vertexBuffer.buffer, scene.visibleInstanceBuffer.buffer};
+        cb.bindVertexBuffers(0, 2, buffers, offsets);
+    }
+
+    cb.bindIndexBuffer(scene.indexBuffer.buffer, 0, scene.indexType);
+
+    // Geometry is bound once per chunk, the culling pass already wrote one instanced draw per batch with anything
+    // visible into the chunk's range and their count.
+    const DrawChunk& drawChunk = scene.drawChunks[chunk];
+
+    if (drawChunk.maxDrawCount > 0) {
+        cb.drawIndexedIndirectCount(scene.indirectBuffer.buffer, drawChunk.firstDraw * sizeof(vk::DrawIndexedIndirectCommand),
+                                    scene.countBuffer.buffer, chunk * sizeof(uint32_t),
+                                    drawChunk.maxDrawCount, sizeof(vk::DrawIndexedIndirectCommand));
+    }
+}
+
 bool App::drawFrame() {
-    auto fenceWait = m_device.waitForFences(m_inFlightFences[m_currentFrame], true, UINT64_MAX);
-
-    auto imageIndex = m_device.acquireNextImageKHR(m_vkbSwapchain.swapchain,
-                                                   UINT64_MAX,
-                                                   m_imageAvailableSems[m_currentFrame],
-                                                   VK_NULL_HANDLE);
-
-    if (imageIndex.result == vk::Result::eErrorOutOfDateKHR) {
-        // logInfo("Recreating Swapchain due to outdated images.");
-        return recreateSwapchain();
-    } else if (imageIndex.result != vk::Result::eSuccess && imageIndex.result != vk::Result::eSuboptimalKHR) {
-        std::cerr << "Failed to acquire swapchain image. Error: " << imageIndex.result << "\n";
-        return false;
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::time_point a, clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    ATOM3D_TRACE_SCOPE("drawFrame");
+
+    m_frameTimings = FrameTimings();
+
+    auto frameStart = clock::now();
+
+    {
+        // Semaphores and queries of this slot were last used MAX_FRAMES_IN_FLIGHT frames ago
+        ATOM3D_TRACE_SCOPE("waitForFrameSlot");
+        m_frameTimeline.wait(m_frameSlotValues[m_currentFrame]);
     }
 
-    if (m_imageInFlightFences[imageIndex.value] != VK_NULL_HANDLE) {
-        fenceWait = m_device.waitForFences(m_imageInFlightFences[imageIndex.value], true, UINT64_MAX);
+    auto waitEnd = clock::now();
+    m_frameTimings.waitMs = ms(frameStart, waitEnd);
+
+    m_transfer.collect();
+    m_delQueue.collect(m_frameTimeline.completed());
+
+    updateShaderReload();
+    m_frameAllocator.beginFrame(m_currentFrame);
+
+    uint32_t imageIndex = 0;
+
+    if (m_settings.headless) {
+        // No presentation engine handing out images, offscreen targets map 1:1 to frames in flight.
+        imageIndex = m_currentFrame;
+    } else {
+        ATOM3D_TRACE_SCOPE("acquireNextImageKHR");
+
+        auto acquireRet = m_device.acquireNextImageKHR(m_vkbSwapchain.swapchain,
+                                                       UINT64_MAX,
+                                                       m_imageAvailableSems[m_currentFrame],
+                                                       VK_NULL_HANDLE);
+
+        if (acquireRet.result == vk::Result::eErrorOutOfDateKHR) {
+            // logInfo("Recreating Swapchain due to outdated images.");
+            return recreateSwapchain();
+        } else if (acquireRet.result != vk::Result::eSuccess && acquireRet.result != vk::Result::eSuboptimalKHR) {
+            std::cerr << "Failed to acquire swapchain image. Error: " << acquireRet.result << "\n";
+            return false;
+        }
+
+        imageIndex = acquireRet.value;
     }
 
+    auto acquireEnd = clock::now();
+    m_frameTimings.acquireMs = ms(waitEnd, acquireEnd);
+
+    // Command buffers go by image, which can come back out of order
+    m_frameTimeline.wait(m_commandBufferValues[imageIndex]);
+
     vk::CommandBufferBeginInfo beginInfo;
-    vk::CommandBuffer cb = m_commandBuffers[imageIndex.value];
+    vk::CommandBuffer cb = m_commandBuffers[imageIndex];
 
     cb.begin(beginInfo);
 
-    recordDrawCommandsScene(cb, imageIndex.value, &m_scene);
+    // Slot wait above guarantees the queries this slot wrote last time around are done, so this never stalls.
+    if (m_gpuProfiler.beginFrame(cb, m_currentFrame)) {
+        m_frameTimings.gpuMs = m_gpuProfiler.latest()->durationMs("frame");
+    }
+
+    // Everything uploaded since last frame goes out as one transfer submission. Finished or not, this frame waits
+    // on it right before its first consumer.
+    std::vector<vk::Semaphore> waitSems;
+    std::vector<vk::PipelineStageFlags> waitStages;
+    std::vector<uint64_t> waitValues;
+
+    m_transfer.flush();
+    m_transfer.acquire(cb, waitSems, waitStages, waitValues);
+
+    uint32_t frameScope = m_gpuProfiler.beginScope(cb, "frame");
+
+    if (m_scene->maxDrawCount > 0) {
+        uint32_t cullScope = m_gpuProfiler.beginScope(cb, "cull");
+        m_culling.record(cb, *m_scene, m_renderExtent.height);
+        m_gpuProfiler.endScope(cb, cullScope);
+    }
+
+    recordDrawCommandsScene(cb, imageIndex, m_scene.get());
+
+    m_gpuProfiler.endScope(cb, frameScope);
 
     cb.end();
 
-    m_imageInFlightFences[imageIndex.value] = m_inFlightFences[m_currentFrame];
+    auto recordEnd = clock::now();
+    m_frameTimings.recordMs = ms(acquireEnd, recordEnd);
 
-    vk::PipelineStageFlags waitStages[] = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
+    if (!m_settings.headless) {
+        waitSems.push_back(m_imageAvailableSems[m_currentFrame]);
+        waitStages.push_back(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+        waitValues.push_back(0);  // Binary, ignored
+    }
+
+    m_frameAllocator.flush();
+
+    const uint64_t frame = m_frameTimeline.nextValue();
+
+    m_frameSlotValues[m_currentFrame] = frame;
+    m_commandBufferValues[imageIndex] = frame;
+
+    std::vector<vk::Semaphore> signalSems = {m_frameTimeline.semaphore()};
+    std::vector<uint64_t> signalValues = {frame};
+
+    if (!m_settings.headless) {
+        signalSems.push_back(m_renderFinishedSems[m_currentFrame]);
+        signalValues.push_back(0);
+    }
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo(waitValues, signalValues);
 
     vk::SubmitInfo subInfo;
-    subInfo.setWaitSemaphores(m_imageAvailableSems[m_currentFrame])
+    subInfo.setCommandBuffers(cb)
+        .setWaitSemaphores(waitSems)
         .setWaitDstStageMask(waitStages)
-        .setCommandBuffers(cb)
-        .setSignalSemaphores(m_renderFinishedSems[m_currentFrame]);
+        .setSignalSemaphores(signalSems)
+        .setPNext(&timelineInfo);
 
-    m_device.resetFences(m_inFlightFences[m_currentFrame]);
+    {
+        ATOM3D_TRACE_SCOPE("submit");
+        m_graphicsQueue.submit(subInfo, nullptr);
+    }
+
+    auto submitEnd = clock::now();
+    m_frameTimings.submitMs = ms(recordEnd, submitEnd);
+    m_frameTimings.rendered = true;
 
-    m_graphicsQueue.submit(subInfo, m_inFlightFences[m_currentFrame]);
+    m_lastImageIndex = imageIndex;
+
+    if (m_settings.headless) {
+        m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        m_frameTimings.cpuMs = ms(frameStart, clock::now());
+        return true;
+    }
 
     // vk::SwapchainKHR tmpswpch = m_vkbSwapchain.swapchain;
 
     vk::PresentInfoKHR presentInfo;
     presentInfo.setWaitSemaphores(m_renderFinishedSems[m_currentFrame])
         .setSwapchains(m_swapchain)
-        .setImageIndices(imageIndex.value);
+        .setImageIndices(imageIndex);
 
-    auto r = m_presentQueue.presentKHR(presentInfo);
+    vk::Result r;
+    {
+        ATOM3D_TRACE_SCOPE("presentKHR");
+        r = m_presentQueue.presentKHR(presentInfo);
+    }
+
+    m_frameTimings.presentMs = ms(submitEnd, clock::now());
 
     if (r == vk::Result::eErrorOutOfDateKHR ||
         r == vk::Result::eSuboptimalKHR ||
@@ -686,6 +1103,8 @@ bool App::drawFrame() {
 
     m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
+    m_frameTimings.cpuMs = ms(frameStart, clock::now());
+
     return true;
 }
 
@@ -700,33 +1119,170 @@ void App::windowLoop() {
     }
 }
 
+bool App::runHeadless(uint32_t frameCount) {
+    for (uint32_t i = 0; i < frameCount; i++) {
+        if (!drawFrame()) {
+            std::cerr << "Failed to draw frame " << i << "\n";
+            return false;
+        }
+    }
+
+    m_frameTimeline.wait(m_frameTimeline.lastSignaled());
+
+    return true;
+}
+
+/// @brief Copies the most recently rendered image back to the host and writes it out as a binary PPM.
+/// Only available in headless mode, swapchain images belong to the presentation engine.
+/// @param path
+bool App::saveFrame(const std::string& path) {
+    if (!m_settings.headless) {
+        logWarning("saveFrame() is only supported in headless mode.");
+        return false;
+    }
+
+    // Only the last frame has to be done rendering. The copy goes on the same queue right behind it, the frame's
+    // final transition (render pass dependency or barrier) already made its writes visible to transfer reads.
+    const uint32_t width = m_renderExtent.width;
+    const uint32_t height = m_renderExtent.height;
+    const vk::DeviceSize size = vk::DeviceSize(width) * height * 4;
+
+    vk::BufferCreateInfo buffInfo;
+    buffInfo.setSize(size)
+        .setUsage(vk::BufferUsageFlagBits::eTransferDst);
+
+    vma::AllocationCreateInfo vmaAllocInfo;
+    vmaAllocInfo.setUsage(vma::MemoryUsage::eAuto)
+        .setFlags(vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessRandom);
+
+    auto [readback, readbackAlloc] = m_vmaAllocator.createBuffer(buffInfo, vmaAllocInfo);
+
+    m_mainCommandBuffer.reset();
+    m_mainCommandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+    // Render pass already left the image in TransferSrcOptimal.
+    vk::BufferImageCopy region;
+    region.setImageSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1))
+        .setImageExtent(vk::Extent3D(m_renderExtent, 1));
+
+    m_mainCommandBuffer.copyImageToBuffer(m_swapchainImages[m_lastImageIndex],
+                                          vk::ImageLayout::eTransferSrcOptimal,
+                                          readback, region);
+
+    m_mainCommandBuffer.end();
+
+    submitAndWait(m_mainCommandBuffer);
+
+    m_vmaAllocator.invalidateAllocation(readbackAlloc, 0, size);
+
+    const uint8_t* pixels = static_cast<const uint8_t*>(m_vmaAllocator.mapMemory(readbackAlloc));
+
+    std::ofstream file(path, std::ios::binary);
+    bool ok = file.is_open();
+
+    if (ok) {
+        file << "P6\n" << width << " " << height << "\n255\n";
+
+        for (size_t p = 0; p < size_t(width) * height; p++) {
+            file.write(reinterpret_cast<const char*>(pixels + p * 4), 3);
+        }
+    } else {
+        std::cerr << "Failed to open " << path << " for writing.\n";
+    }
+
+    m_vmaAllocator.unmapMemory(readbackAlloc);
+    m_vmaAllocator.destroyBuffer(readback, readbackAlloc);
+
+    return ok;
+}
+
+/// @brief Submits cb to the graphics queue and blocks until it's done. Outside of the frame loop only (init,
+/// readbacks), it counts as a frame of its own on the frame timeline, waiting on its value waits for cb and nothing
+/// else.
+/// @param cb
+void App::submitAndWait(vk::CommandBuffer cb) {
+    const uint64_t done = m_frameTimeline.nextValue();
+    vk::Semaphore timeline = m_frameTimeline.semaphore();
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo;
+    timelineInfo.setSignalSemaphoreValues(done);
+
+    vk::SubmitInfo subInfo;
+    subInfo.setCommandBuffers(cb)
+        .setSignalSemaphores(timeline)
+        .setPNext(&timelineInfo);
+
+    m_graphicsQueue.submit(subInfo, nullptr);
+    m_frameTimeline.wait(done);
+}
+
 void App::destroy() {
     m_device.waitIdle();
 
+    // Rebuilds still in flight use the device, pipeline cache and layouts, this lets them finish
+    m_compiler.destroy();
+
+    m_shaderWatcher.destroy();
+    m_delQueue.flush();
+
     destroySyncObjects();
+    m_recorder.destroy();
+    m_gpuProfiler.destroy();
 
     cleanupSwapchain();
 
     // vkb::destroy_swapchain(m_vkbSwapchain);
 
-    m_device.destroyPipeline(m_graphicsPipeline);
-    m_device.destroyPipelineLayout(m_pipelineLayout);
+    m_culling.destroy();
+
+    // Pipelines and layouts, including whatever a pending rebuild finished with
+    m_pipelines.destroy();
+
+    // Everything got compiled by now, next launch starts off with all of it
+    m_pipelineCache.save();
+    m_pipelineCache.destroy();
     m_device.destroyRenderPass(m_renderPass);
 
-    m_vmaAllocator.destroyBuffer(m_scene.buffer.buffer, m_scene.buffer.allocation);
+    m_transfer.destroy();
+    m_frameAllocator.destroy();
+    m_bindless.destroy();
+    m_scene->destroyBuffers(m_vmaAllocator);
     m_vmaAllocator.destroy();
 
     m_device = VK_NULL_HANDLE;
     m_instance = VK_NULL_HANDLE;
 
     vkb::destroy_device(m_vkbDevice);
-    vkb::destroy_surface(m_vkbInstance, m_surface);
+    if (!m_settings.headless) {
+        vkb::destroy_surface(m_vkbInstance, m_surface);
+    }
     vkb::destroy_instance(m_vkbInstance);
 
-    glfwDestroyWindow(m_glfwWindow);
-    glfwTerminate();
+    if (!m_settings.headless) {
+        glfwDestroyWindow(m_glfwWindow);
+        glfwTerminate();
+    }
 }
 
 void App::setupScene() {
-    m_scene.uploadMeshes(m_vmaAllocator, m_mainCommandBuffer, m_graphicsQueue);
+    // One draw chunk per recording thread
+    m_scene->drawChunkCount = m_recorder.threadCount();
+    m_scene->uploadMeshes(m_vmaAllocator, m_transfer);
+    m_transfer.flush();
+
+    // Empty scenes don't get buffers and don't draw either
+    if (m_scene->materialBuffer.buffer) {
+        m_scenePush.materialBuffer = m_bindless.addStorageBuffer(m_scene->materialBuffer.buffer);
+    }
+
+    if (m_scene->vertexBuffer.buffer) {
+        m_scenePush.vertices = m_device.getBufferAddress(vk::BufferDeviceAddressInfo(m_scene->vertexBuffer.buffer));
+        m_scenePush.instances = m_device.getBufferAddress(vk::BufferDeviceAddressInfo(m_scene->visibleInstanceBuffer.buffer));
+    }
+}
+
+/// @brief Overrides the default scene, has to be called before init().
+/// @param scene
+void App::setScene(std::unique_ptr<Scene> scene) {
+    m_scene = std::move(scene);
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "Bindless.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+uint32_t BindlessDescriptors::SlotAllocator::allocate() {
+    if (!freed.empty()) {
+        uint32_t slot = freed.back();
+        freed.pop_back();
+        return slot;
+    }
+
+    if (next >= capacity) {
+        return BINDLESS_INVALID_SLOT;
+    }
+
+    return next++;
+}
+
+bool BindlessDescriptors::init(vk::Device device, vk::PhysicalDevice physicalDevice, PipelineStateCache& pipelines, vma::Allocator allocator) {
+    m_device = device;
+    m_allocator = allocator;
+
+    // Update after bind descriptors have limits of their own, usually far above the regular per stage ones
+    auto props = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties>();
+    const auto& indexing = props.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+
+    m_images = {};
+    m_samplers = {};
+    m_storageBuffers = {};
+
+    m_images.capacity = std::min({BINDLESS_MAX_IMAGES, indexing.maxDescriptorSetUpdateAfterBindSampledImages,
+                                  indexing.maxPerStageDescriptorUpdateAfterBindSampledImages});
+    m_samplers.capacity = std::min({BINDLESS_MAX_SAMPLERS, indexing.maxDescriptorSetUpdateAfterBindSamplers,
+                                    indexing.maxPerStageDescriptorUpdateAfterBindSamplers});
+    m_storageBuffers.capacity = std::min({BINDLESS_MAX_STORAGE_BUFFERS, indexing.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                          indexing.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+
+    // All three count towards one per stage total as well, images give way since they're the big one
+    uint32_t others = m_samplers.capacity + m_storageBuffers.capacity;
+
+    if (m_images.capacity + others > indexing.maxPerStageUpdateAfterBindResources) {
+        m_images.capacity = indexing.maxPerStageUpdateAfterBindResources > others ? indexing.maxPerStageUpdateAfterBindResources - others : 0;
+    }
+
+    if (m_images.capacity == 0 || m_samplers.capacity == 0 || m_storageBuffers.capacity == 0) {
+        std::cerr << "Device doesn't support update after bind descriptors.\n";
+        return false;
+    }
+
+    const vk::ShaderStageFlags stages = vk::ShaderStageFlagBits::eAllGraphics | vk::ShaderStageFlagBits::eCompute;
+
+    // Slots nobody wrote yet are fine as long as shaders don't read them, slots frames in flight don't use can be
+    // written while those are pending
+    const vk::DescriptorBindingFlags flags = vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+                                             vk::DescriptorBindingFlagBits::ePartiallyBound |
+                                             vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+
+    DescriptorSetLayoutDesc layoutDesc;
+    layoutDesc.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+    layoutDesc.addBinding(BINDLESS_BINDING_IMAGES, vk::DescriptorType::eSampledImage, m_images.capacity, stages, flags)
+        .addBinding(BINDLESS_BINDING_SAMPLERS, vk::DescriptorType::eSampler, m_samplers.capacity, stages, flags)
+        .addBinding(BINDLESS_BINDING_STORAGE_BUFFERS, vk::DescriptorType::eStorageBuffer, m_storageBuffers.capacity, stages, flags);
+
+    m_setLayout = pipelines.descriptorSetLayout(layoutDesc);
+
+    std::array<vk::DescriptorPoolSize, 3> poolSizes = {
+        vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, m_images.capacity),
+        vk::DescriptorPoolSize(vk::DescriptorType::eSampler, m_samplers.capacity),
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, m_storageBuffers.capacity),
+    };
+
+    m_descriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind, 1, poolSizes));
+    m_descriptorSet = m_device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPool, m_setLayout))[0];
+
+    // Defaults, so that a material that doesn't set anything samples plain white
+    m_defaultImage = AllocatedImage::createImage(m_allocator, m_device, vk::Extent2D(1, 1), vk::Format::eR8G8B8A8Unorm,
+                                                 vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
+
+    vk::SamplerCreateInfo samplerInfo;
+    samplerInfo.setMagFilter(vk::Filter::eLinear)
+        .setMinFilter(vk::Filter::eLinear)
+        .setMipmapMode(vk::SamplerMipmapMode::eLinear)
+        .setAddressModeU(vk::SamplerAddressMode::eRepeat)
+        .setAddressModeV(vk::SamplerAddressMode::eRepeat)
+        .setAddressModeW(vk::SamplerAddressMode::eRepeat)
+        .setMaxLod(VK_LOD_CLAMP_NONE);
+
+    m_defaultSampler = m_device.createSampler(samplerInfo);
+
+    if (addImage(m_defaultImage.view) != BINDLESS_DEFAULT_IMAGE || addSampler(m_defaultSampler) != BINDLESS_DEFAULT_SAMPLER) {
+        std::cerr << "Failed to register the default bindless resources.\n";
+        return false;
+    }
+
+    return true;
+}
+
+void BindlessDescriptors::destroy() {
+    m_device.destroyDescriptorPool(m_descriptorPool);
+    m_device.destroySampler(m_defaultSampler);
+
+    if (m_defaultImage.image) {
+        AllocatedImage::destroyImage(m_allocator, m_device, m_defaultImage);
+    }
+
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_setLayout = VK_NULL_HANDLE;
+    m_defaultSampler = VK_NULL_HANDLE;
+}
+
+void BindlessDescriptors::recordDefaults(vk::CommandBuffer cb) {
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+    vk::ImageMemoryBarrier barrier;
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eNone)
+        .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+        .setOldLayout(vk::ImageLayout::eUndefined)
+        .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setImage(m_defaultImage.image)
+        .setSubresourceRange(range);
+
+    cb.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barrier);
+
+    cb.clearColorImage(m_defaultImage.image, vk::ImageLayout::eTransferDstOptimal, vk::ClearColorValue(1.f, 1.f, 1.f, 1.f), range);
+
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+        .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+        .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                       vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+                       {}, nullptr, nullptr, barrier);
+}
+
+uint32_t BindlessDescriptors::addImage(vk::ImageView view, vk::ImageLayout layout) {
+    uint32_t slot = m_images.allocate();
+
+    if (slot == BINDLESS_INVALID_SLOT) {
+        std::cerr << "Bindless image array full (" << m_images.capacity << ").\n";
+        return slot;
+    }
+
+    vk::DescriptorImageInfo info(nullptr, view, layout);
+
+    vk::WriteDescriptorSet write(m_descriptorSet, BINDLESS_BINDING_IMAGES, slot, vk::DescriptorType::eSampledImage, info);
+    m_device.updateDescriptorSets(write, nullptr);
+
+    return slot;
+}
+
+uint32_t BindlessDescriptors::addSampler(vk::Sampler sampler) {
+    uint32_t slot = m_samplers.allocate();
+
+    if (slot == BINDLESS_INVALID_SLOT) {
+        std::cerr << "Bindless sampler array full (" << m_samplers.capacity << ").\n";
+        return slot;
+    }
+
+    vk::DescriptorImageInfo info(sampler, nullptr, vk::ImageLayout::eUndefined);
+
+    vk::WriteDescriptorSet write(m_descriptorSet, BINDLESS_BINDING_SAMPLERS, slot, vk::DescriptorType::eSampler, info);
+    m_device.updateDescriptorSets(write, nullptr);
+
+    return slot;
+}
+
+uint32_t BindlessDescriptors::addStorageBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range) {
+    uint32_t slot = m_storageBuffers.allocate();
+
+    if (slot == BINDLESS_INVALID_SLOT) {
+        std::cerr << "Bindless storage buffer array full (" << m_storageBuffers.capacity << ").\n";
+        return slot;
+    }
+
+    vk::DescriptorBufferInfo info(buffer, offset, range);
+
+    vk::WriteDescriptorSet write(m_descriptorSet, BINDLESS_BINDING_STORAGE_BUFFERS, slot, vk::DescriptorType::eStorageBuffer, nullptr, info);
+    m_device.updateDescriptorSets(write, nullptr);
+
+    return slot;
+}
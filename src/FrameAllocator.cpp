@@ -0,0 +1,99 @@
+#include "FrameAllocator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+bool FrameAllocator::init(vk::Device device, PipelineStateCache& pipelines, vma::Allocator allocator, const vk::PhysicalDeviceLimits& limits,
+                          uint32_t framesInFlight) {
+    m_device = device;
+    m_allocator = allocator;
+
+    m_uniformAlignment = std::max<vk::DeviceSize>(limits.minUniformBufferOffsetAlignment, 16);
+    m_storageAlignment = std::max<vk::DeviceSize>(limits.minStorageBufferOffsetAlignment, 16);
+
+    // Every binding covers a fixed range past its dynamic offset, the tail keeps that in bounds for allocations at
+    // the very end of the last region.
+    vk::DeviceSize size = FRAME_ALLOCATOR_SIZE * framesInFlight + std::max(FRAME_UNIFORM_RANGE, FRAME_STORAGE_RANGE);
+
+    m_buffer = AllocatedBuffer::createBuffer(m_allocator, size,
+                                             vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer,
+                                             vma::MemoryUsage::eAuto);
+
+    m_mapped = static_cast<uint8_t*>(m_allocator.getAllocationInfo(m_buffer.allocation).pMappedData);
+
+    if (!m_mapped) {
+        std::cerr << "Failed to map the frame allocator.\n";
+        return false;
+    }
+
+    const vk::ShaderStageFlags stages = vk::ShaderStageFlagBits::eAllGraphics | vk::ShaderStageFlagBits::eCompute;
+
+    DescriptorSetLayoutDesc layoutDesc;
+    layoutDesc.addBinding(0, vk::DescriptorType::eUniformBufferDynamic, 1, stages)
+        .addBinding(1, vk::DescriptorType::eStorageBufferDynamic, 1, stages);
+
+    m_setLayout = pipelines.descriptorSetLayout(layoutDesc);
+
+    std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+        vk::DescriptorPoolSize(vk::DescriptorType::eUniformBufferDynamic, 1),
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageBufferDynamic, 1),
+    };
+
+    m_descriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo({}, 1, poolSizes));
+    m_descriptorSet = m_device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPool, m_setLayout))[0];
+
+    // Written once, only the dynamic offsets change from here on
+    vk::DescriptorBufferInfo uniformInfo(m_buffer.buffer, 0, FRAME_UNIFORM_RANGE);
+    vk::DescriptorBufferInfo storageInfo(m_buffer.buffer, 0, FRAME_STORAGE_RANGE);
+
+    std::array<vk::WriteDescriptorSet, 2> writes = {
+        vk::WriteDescriptorSet(m_descriptorSet, 0, 0, vk::DescriptorType::eUniformBufferDynamic, nullptr, uniformInfo),
+        vk::WriteDescriptorSet(m_descriptorSet, 1, 0, vk::DescriptorType::eStorageBufferDynamic, nullptr, storageInfo),
+    };
+
+    m_device.updateDescriptorSets(writes, nullptr);
+
+    return true;
+}
+
+void FrameAllocator::destroy() {
+    m_device.destroyDescriptorPool(m_descriptorPool);
+
+    if (m_buffer.buffer) {
+        m_allocator.destroyBuffer(m_buffer.buffer, m_buffer.allocation);
+    }
+
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_setLayout = VK_NULL_HANDLE;
+    m_buffer = {};
+    m_mapped = nullptr;
+}
+
+void FrameAllocator::beginFrame(uint32_t frameSlot) {
+    m_frameStart = FRAME_ALLOCATOR_SIZE * frameSlot;
+    m_head = m_frameStart;
+}
+
+void FrameAllocator::flush() {
+    if (m_head > m_frameStart) {
+        m_allocator.flushAllocation(m_buffer.allocation, m_frameStart, m_head - m_frameStart);
+    }
+}
+
+FrameAllocator::Allocation FrameAllocator::allocate(vk::DeviceSize size, vk::DeviceSize alignment) {
+    vk::DeviceSize offset = (m_head + alignment - 1) / alignment * alignment;
+
+    if (offset + size > m_frameStart + FRAME_ALLOCATOR_SIZE) {
+        if (!m_overflowReported) {
+            std::cerr << "Frame allocator out of space (" << FRAME_ALLOCATOR_SIZE << " bytes per frame).\n";
+            m_overflowReported = true;
+        }
+
+        return {};
+    }
+
+    m_head = offset + size;
+
+    return {m_mapped + offset, static_cast<uint32_t>(offset)};
+}
@@ -0,0 +1,180 @@
+#include "GpuCulling.hpp"
+
+#include <cmath>
+#include <iostream>
+
+constexpr uint32_t CULL_WORKGROUP_SIZE = 64;  // local_size_x in cull.comp
+
+// Instances, mesh infos, batches, batch counts, visible instances, draw commands, draw counts, instance slots
+constexpr uint32_t CULL_BINDING_COUNT = 8;
+
+DescriptorSetLayoutDesc GpuCulling::setLayoutDesc() {
+    DescriptorSetLayoutDesc desc;
+
+    for (uint32_t i = 0; i < CULL_BINDING_COUNT; i++) {
+        desc.addBinding(i, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+    }
+
+    return desc;
+}
+
+PipelineLayoutDesc GpuCulling::pipelineLayoutDesc(PipelineStateCache& pipelines) {
+    PipelineLayoutDesc desc;
+    desc.addSetLayout(pipelines.descriptorSetLayout(setLayoutDesc()))
+        .addPushConstants(vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullPushConstants));
+
+    return desc;
+}
+
+ComputePipelineDesc GpuCulling::pipelineDesc(PipelineStateCache& pipelines, const std::vector<char>& cullCode) {
+    ComputePipelineDesc desc;
+    desc.setShader(cullCode).setLayout(pipelines.pipelineLayout(pipelineLayoutDesc(pipelines)));
+
+    return desc;
+}
+
+bool GpuCulling::init(vk::Device device, PipelineStateCache& pipelines, const Scene& scene, vk::Pipeline pipeline) {
+    m_device = device;
+
+    // Same descriptions, so the same layouts pipelineDesc() used
+    m_setLayout = pipelines.descriptorSetLayout(setLayoutDesc());
+    m_pipelineLayout = pipelines.pipelineLayout(pipelineLayoutDesc(pipelines));
+    m_pipeline = pipeline;
+
+    if (!m_pipeline) {
+        std::cerr << "Failed to create culling pipeline.\n";
+        return false;
+    }
+
+    // Nothing to draw, uploadMeshes() left every buffer null and record() is never called
+    if (scene.maxDrawCount == 0) {
+        return true;
+    }
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, CULL_BINDING_COUNT);
+    m_descriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo({}, 1, poolSize));
+
+    m_descriptorSet = m_device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPool, m_setLayout))[0];
+
+    std::array<vk::DescriptorBufferInfo, CULL_BINDING_COUNT> bufferInfos = {
+        vk::DescriptorBufferInfo(scene.instanceBuffer.buffer, 0, vk::WholeSize),
+        vk::DescriptorBufferInfo(scene.meshInfoBuffer.buffer, 0, vk::WholeSize),
+        vk::DescriptorBufferInfo(scene.batchBuffer.buffer, 0, vk::WholeSize),
+        vk::DescriptorBufferInfo(scene.batchCountBuffer.buffer, 0, vk::WholeSize),
+        vk::DescriptorBufferInfo(scene.visibleInstanceBuffer.buffer, 0, vk::WholeSize),
+        vk::DescriptorBufferInfo(scene.indirectBuffer.buffer, 0, vk::WholeSize),
+        vk::DescriptorBufferInfo(scene.countBuffer.buffer, 0, vk::WholeSize),
+        vk::DescriptorBufferInfo(scene.instanceSlotBuffer.buffer, 0, vk::WholeSize),
+    };
+
+    std::array<vk::WriteDescriptorSet, CULL_BINDING_COUNT> writes;
+
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i] = vk::WriteDescriptorSet(m_descriptorSet, i, 0, vk::DescriptorType::eStorageBuffer, nullptr, bufferInfos[i]);
+    }
+
+    m_device.updateDescriptorSets(writes, nullptr);
+
+    return true;
+}
+
+void GpuCulling::destroy() {
+    // Layouts and pipeline belong to the PipelineStateCache
+    m_device.destroyDescriptorPool(m_descriptorPool);
+
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipelineLayout = VK_NULL_HANDLE;
+    m_descriptorPool = VK_NULL_HANDLE;
+    m_setLayout = VK_NULL_HANDLE;
+}
+
+void GpuCulling::record(vk::CommandBuffer cb, const Scene& scene, uint32_t viewportHeight) {
+    // Last frame's draws may still be reading the outputs, one queue so an execution dependency is enough.
+    // Vertex shader for vertex pulling.
+    cb.pipelineBarrier(vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput |
+                           vk::PipelineStageFlagBits::eVertexShader,
+                       vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader,
+                       {}, nullptr, nullptr, nullptr);
+
+    cb.fillBuffer(scene.countBuffer.buffer, 0, vk::WholeSize, 0);
+    cb.fillBuffer(scene.batchCountBuffer.buffer, 0, vk::WholeSize, 0);
+
+    vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite,
+                                   vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+    cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                       vk::PipelineStageFlagBits::eComputeShader,
+                       {}, clearBarrier, nullptr, nullptr);
+
+    const glm::mat4 viewProjection = scene.camera.viewProjection();
+
+    CullPushConstants push;
+    extractFrustumPlanes(viewProjection, push.planes);
+    push.wRow = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+    push.instanceCount = static_cast<uint32_t>(scene.instances.size());
+    push.batchCount = static_cast<uint32_t>(scene.batches.size());
+    push.flags = (m_frustumCulling ? CULL_FLAG_CULLING : 0) | (m_lodThresholdPixels > 0.f ? CULL_FLAG_LOD : 0);
+
+    // A clip space distance d at depth w covers d / w * height / 2 pixels, projection[1][1] brings view space
+    // distances into clip space.
+    float pixelsPerUnit = std::abs(scene.camera.projection[1][1]) * viewportHeight * 0.5f;
+    push.lodFactor = pixelsPerUnit > 0.f ? m_lodThresholdPixels / pixelsPerUnit : 0.f;
+
+    cb.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+    cb.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, nullptr);
+
+    // Phase 0, cull instances
+    cb.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullPushConstants), &push);
+    cb.dispatch((push.instanceCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+    vk::MemoryBarrier countBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+    cb.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                       vk::PipelineStageFlagBits::eComputeShader,
+                       {}, countBarrier, nullptr, nullptr);
+
+    const uint32_t cullFlags = push.flags;
+
+    // Phase 1, build draws, one thread per (batch, LOD)
+    push.flags = cullFlags | CULL_FLAG_PHASE_DRAWS;
+    cb.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullPushConstants), &push);
+    cb.dispatch((push.batchCount * MAX_MESH_LODS + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+    // Phase 2, write visible instances at their slots, only reads what phase 0 wrote
+    push.flags = cullFlags | CULL_FLAG_PHASE_INSTANCES;
+    cb.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullPushConstants), &push);
+    cb.dispatch((push.instanceCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+    // Visible instances are either vertex attributes or, with vertex pulling, read by the vertex shader
+    vk::MemoryBarrier cullBarrier(vk::AccessFlagBits::eShaderWrite,
+                                  vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead |
+                                      vk::AccessFlagBits::eShaderRead);
+
+    cb.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                       vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput |
+                           vk::PipelineStageFlagBits::eVertexShader,
+                       {}, cullBarrier, nullptr, nullptr);
+}
+
+void GpuCulling::extractFrustumPlanes(const glm::mat4& m, glm::vec4 planes[6]) {
+    // glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 r0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 r1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 r2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 r3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = r3 + r0;  // Left
+    planes[1] = r3 - r0;  // Right
+    planes[2] = r3 + r1;  // Top (Vulkan y points down)
+    planes[3] = r3 - r1;  // Bottom
+    planes[4] = r2;       // Near, z >= 0
+    planes[5] = r3 - r2;  // Far
+
+    for (int i = 0; i < 6; i++) {
+        float len = glm::length(glm::vec3(planes[i]));
+
+        if (len > 0.f) {
+            planes[i] /= len;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#include "GpuProfiler.hpp"
+
+#include <fstream>
+#include <iostream>
+
+bool GpuProfiler::init(vk::Device device, const vkb::PhysicalDevice& physDevice, uint32_t queueFamily, uint32_t framesInFlight) {
+    m_device = device;
+
+    const auto& limits = physDevice.properties.limits;
+    uint32_t validBits = physDevice.get_queue_families()[queueFamily].timestampValidBits;
+
+    if (!limits.timestampComputeAndGraphics || limits.timestampPeriod == 0.0f || validBits == 0) {
+        return false;
+    }
+
+    m_timestampPeriodNs = limits.timestampPeriod;
+    m_timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+    vk::QueryPoolCreateInfo info({}, vk::QueryType::eTimestamp, 2 * GPU_PROFILER_MAX_SCOPES);
+
+    m_pools.resize(framesInFlight);
+    m_slots.resize(framesInFlight);
+
+    for (auto& p : m_pools) {
+        p = m_device.createQueryPool(info);
+    }
+
+    return true;
+}
+
+void GpuProfiler::destroy() {
+    for (auto& p : m_pools) {
+        m_device.destroyQueryPool(p);
+    }
+
+    m_pools.clear();
+    m_slots.clear();
+    m_history.clear();
+}
+
+bool GpuProfiler::beginFrame(vk::CommandBuffer cb, uint32_t frameSlot) {
+    if (!enabled()) {
+        return false;
+    }
+
+    m_currentSlot = frameSlot;
+
+    FrameSlot& slot = m_slots[frameSlot];
+    vk::QueryPool pool = m_pools[frameSlot];
+    bool collected = false;
+
+    if (!slot.names.empty()) {
+        uint32_t count = 2 * static_cast<uint32_t>(slot.names.size());
+
+        // The caller waited on this slot's fence already, so everything in it is available.
+        auto ts = m_device.getQueryPoolResults<uint64_t>(pool, 0, count,
+                                                         count * sizeof(uint64_t), sizeof(uint64_t),
+                                                         vk::QueryResultFlagBits::e64);
+
+        if (ts.result == vk::Result::eSuccess) {
+            GpuFrameResult result;
+            result.frame = slot.frame;
+            result.scopes.reserve(slot.names.size());
+
+            for (size_t i = 0; i < slot.names.size(); i++) {
+                uint64_t ticks = (ts.value[2 * i + 1] - ts.value[2 * i]) & m_timestampMask;
+                result.scopes.push_back({slot.names[i], double(ticks) * m_timestampPeriodNs * 1e-6});
+            }
+
+            m_history.push_back(std::move(result));
+
+            if (m_history.size() > GPU_PROFILER_HISTORY) {
+                m_history.pop_front();
+            }
+
+            collected = true;
+        }
+    }
+
+    slot.names.clear();
+    slot.frame = m_frameCounter++;
+
+    cb.resetQueryPool(pool, 0, 2 * GPU_PROFILER_MAX_SCOPES);
+
+    return collected;
+}
+
+uint32_t GpuProfiler::beginScope(vk::CommandBuffer cb, const char* name) {
+    if (!enabled()) {
+        return UINT32_MAX;
+    }
+
+    FrameSlot& slot = m_slots[m_currentSlot];
+
+    if (slot.names.size() >= GPU_PROFILER_MAX_SCOPES) {
+        return UINT32_MAX;
+    }
+
+    uint32_t scope = static_cast<uint32_t>(slot.names.size());
+    slot.names.push_back(name);
+
+    cb.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_pools[m_currentSlot], 2 * scope);
+
+    return scope;
+}
+
+void GpuProfiler::endScope(vk::CommandBuffer cb, uint32_t scope) {
+    if (scope == UINT32_MAX) {
+        return;
+    }
+
+    cb.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_pools[m_currentSlot], 2 * scope + 1);
+}
+
+bool GpuProfiler::exportJson(const std::string& path) const {
+    std::ofstream file(path);
+
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << path << " for writing.\n";
+        return false;
+    }
+
+    file << "{\n  \"unit\": \"ms\",\n  \"frames\": [\n";
+
+    for (size_t f = 0; f < m_history.size(); f++) {
+        const GpuFrameResult& r = m_history[f];
+
+        file << "    {\"frame\": " << r.frame << ", \"passes\": {";
+
+        for (size_t i = 0; i < r.scopes.size(); i++) {
+            file << "\"" << r.scopes[i].name << "\": " << r.scopes[i].ms << (i + 1 < r.scopes.size() ? ", " : "");
+        }
+
+        file << "}}" << (f + 1 < m_history.size() ? ",\n" : "\n");
+    }
+
+    file << "  ]\n}\n";
+
+    return true;
+}
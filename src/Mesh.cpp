@@ -1 +1,202 @@
-#include "Mesh.hpp"
\ No newline at end of file
+#include "Mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include <glm/gtc/packing.hpp>
+
+#include "MeshSimplify.hpp"
+
+// Simplifying further than this isn't worth another draw range
+constexpr size_t MIN_LOD_TRIANGLES = 64;
+
+void Mesh::weldVertices() {
+    if (indices.empty()) {
+        indices.resize(vertices.size());
+
+        for (uint32_t i = 0; i < indices.size(); i++) {
+            indices[i] = i;
+        }
+    }
+
+    std::unordered_map<Vertex, uint32_t, VertexHash> unique;
+    unique.reserve(vertices.size());
+
+    std::vector<Vertex> welded;
+    welded.reserve(vertices.size());
+
+    // Old vertex index -> welded vertex index
+    std::vector<uint32_t> remap(vertices.size());
+
+    for (uint32_t i = 0; i < vertices.size(); i++) {
+        auto [it, inserted] = unique.try_emplace(vertices[i], static_cast<uint32_t>(welded.size()));
+
+        if (inserted) {
+            welded.push_back(vertices[i]);
+        }
+
+        remap[i] = it->second;
+    }
+
+    for (auto& idx : indices) {
+        idx = remap[idx];
+    }
+
+    for (auto& lod : lods) {
+        for (auto& idx : lod.indices) {
+            idx = remap[idx];
+        }
+    }
+
+    vertices = std::move(welded);
+}
+
+glm::vec4 Mesh::boundingSphere() const {
+    if (vertices.empty()) {
+        return glm::vec4(0.f);
+    }
+
+    glm::vec3 lo = vertices[0].pos;
+    glm::vec3 hi = vertices[0].pos;
+
+    for (const auto& v : vertices) {
+        lo = glm::min(lo, v.pos);
+        hi = glm::max(hi, v.pos);
+    }
+
+    glm::vec3 center = (lo + hi) * 0.5f;
+    float radius = 0.f;
+
+    for (const auto& v : vertices) {
+        radius = std::max(radius, glm::length(v.pos - center));
+    }
+
+    return glm::vec4(center, radius);
+}
+
+VertexDequant Mesh::quantize(VertexFormat format, std::vector<PackedVertex>& out) const {
+    VertexDequant dequant;
+
+    if (vertices.empty()) {
+        return dequant;
+    }
+
+    glm::vec3 lo = vertices[0].pos;
+    glm::vec3 hi = vertices[0].pos;
+
+    for (const auto& v : vertices) {
+        lo = glm::min(lo, v.pos);
+        hi = glm::max(hi, v.pos);
+    }
+
+    dequant.offset = (lo + hi) * 0.5f;
+    dequant.scale = (hi - lo) * 0.5f;
+
+    // Flat axes, anything maps to the center
+    for (int i = 0; i < 3; i++) {
+        if (dequant.scale[i] <= 0.f) {
+            dequant.scale[i] = 1.f;
+        }
+    }
+
+    out.reserve(out.size() + vertices.size());
+
+    for (const auto& v : vertices) {
+        glm::vec4 q(glm::clamp((v.pos - dequant.offset) / dequant.scale, -1.f, 1.f), 1.f);
+
+        PackedVertex p;
+        p.pos = format == VertexFormat::Half ? glm::packHalf4x16(q) : glm::packSnorm4x16(q);
+        p.color = glm::packUnorm4x8(glm::vec4(v.color, 1.f));
+        p.texCoord = glm::packHalf2x16(v.texCoord);
+
+        out.push_back(p);
+    }
+
+    return dequant;
+}
+
+void Mesh::generateLods() {
+    lods.clear();
+
+    size_t target = indices.size();
+    float prevError = 0.f;
+
+    for (uint32_t l = 1; l < MAX_MESH_LODS; l++) {
+        target = (target / 2) / 3 * 3;
+
+        if (target < MIN_LOD_TRIANGLES * 3) {
+            break;
+        }
+
+        // Always from LOD 0, errors don't pile up that way
+        MeshLod lod;
+        lod.indices = simplifyMesh(vertices, indices, target, &lod.error);
+        lod.error = std::max(lod.error, prevError);
+
+        size_t previous = lods.empty() ? indices.size() : lods.back().indices.size();
+
+        if (lod.indices.size() > previous * 9 / 10) {
+            break;
+        }
+
+        prevError = lod.error;
+        lods.push_back(std::move(lod));
+    }
+}
+
+void Mesh::sphere(Mesh& mesh, uint32_t rings, uint32_t segments) {
+    const float pi = 3.14159265358979f;
+
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    mesh.lods.clear();
+
+    auto makeVertex = [&](float theta, float phi) {
+        Vertex v;
+        v.pos = {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+        v.color = v.pos * 0.5f + glm::vec3(0.5f);
+        v.texCoord = {phi / (2.f * pi), theta / pi};
+        return v;
+    };
+
+    // Poles are single vertices. Every ring repeats its first vertex at u = 1 so texturing doesn't wrap back across
+    // the whole last segment, the copy keeps the exact position so simplification sees (and locks) the seam.
+    mesh.vertices.push_back(makeVertex(0.f, 0.f));
+
+    for (uint32_t r = 1; r < rings; r++) {
+        const size_t first = mesh.vertices.size();
+
+        for (uint32_t s = 0; s < segments; s++) {
+            mesh.vertices.push_back(makeVertex(pi * r / rings, 2.f * pi * s / segments));
+        }
+
+        Vertex seam = mesh.vertices[first];
+        seam.texCoord.x = 1.f;
+        mesh.vertices.push_back(seam);
+    }
+
+    mesh.vertices.push_back(makeVertex(pi, 0.f));
+
+    const uint32_t south = static_cast<uint32_t>(mesh.vertices.size() - 1);
+
+    auto at = [&](uint32_t r, uint32_t s) -> uint32_t {
+        if (r == 0) return 0;
+        if (r == rings) return south;
+        return 1 + (r - 1) * (segments + 1) + s;
+    };
+
+    for (uint32_t r = 0; r < rings; r++) {
+        for (uint32_t s = 0; s < segments; s++) {
+            uint32_t a = at(r, s), b = at(r + 1, s), c = at(r + 1, s + 1), d = at(r, s + 1);
+
+            if (r != rings - 1) {
+                mesh.indices.insert(mesh.indices.end(), {a, b, c});
+            }
+
+            if (r != 0) {
+                mesh.indices.insert(mesh.indices.end(), {a, c, d});
+            }
+        }
+    }
+}
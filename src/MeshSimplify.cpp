@@ -0,0 +1,252 @@
+#include "MeshSimplify.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+// Symmetric 4x4 matrix, upper triangle: aa ab ac ad bb bc bd cc cd dd
+struct Quadric {
+    double m[10] = {};
+
+    static Quadric fromPlane(double a, double b, double c, double d) {
+        Quadric q;
+        q.m[0] = a * a; q.m[1] = a * b; q.m[2] = a * c; q.m[3] = a * d;
+        q.m[4] = b * b; q.m[5] = b * c; q.m[6] = b * d;
+        q.m[7] = c * c; q.m[8] = c * d;
+        q.m[9] = d * d;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& o) {
+        for (int i = 0; i < 10; i++) m[i] += o.m[i];
+        return *this;
+    }
+
+    double evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+
+        return m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x +
+               m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y +
+               m[7] * z * z + 2 * m[8] * z +
+               m[9];
+    }
+};
+
+struct Collapse {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+    uint32_t fromVersion;
+    uint32_t toVersion;
+
+    bool operator>(const Collapse& o) const { return cost > o.cost; }
+};
+
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+    if (a > b) std::swap(a, b);
+    return (uint64_t(a) << 32) | b;
+}
+
+}  // namespace
+
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices,
+                                   const std::vector<uint32_t>& indices,
+                                   size_t targetIndexCount,
+                                   float* outError) {
+    const size_t vertexCount = vertices.size();
+    const size_t triCount = indices.size() / 3;
+
+    std::vector<uint32_t> tris(indices.begin(), indices.begin() + triCount * 3);
+    std::vector<bool> triAlive(triCount, true);
+    size_t aliveTris = triCount;
+
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::vector<uint32_t>> vertexTris(vertexCount);
+    std::vector<bool> locked(vertexCount, false);
+    std::vector<bool> removed(vertexCount, false);
+    std::vector<uint32_t> version(vertexCount, 0);
+
+    // Plane quadrics and adjacency
+    for (uint32_t t = 0; t < triCount; t++) {
+        const glm::vec3& p0 = vertices[tris[3 * t + 0]].pos;
+        const glm::vec3& p1 = vertices[tris[3 * t + 1]].pos;
+        const glm::vec3& p2 = vertices[tris[3 * t + 2]].pos;
+
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        float len = glm::length(n);
+
+        if (len > 0.f) {
+            n /= len;
+
+            Quadric q = Quadric::fromPlane(n.x, n.y, n.z, -glm::dot(n, p0));
+
+            for (int c = 0; c < 3; c++) {
+                quadrics[tris[3 * t + c]] += q;
+            }
+        }
+
+        for (int c = 0; c < 3; c++) {
+            vertexTris[tris[3 * t + c]].push_back(t);
+        }
+    }
+
+    // Borders, edges with a single triangle
+    std::unordered_map<uint64_t, uint32_t> edgeUse;
+    edgeUse.reserve(triCount * 3);
+
+    for (uint32_t t = 0; t < triCount; t++) {
+        for (int c = 0; c < 3; c++) {
+            edgeUse[edgeKey(tris[3 * t + c], tris[3 * t + (c + 1) % 3])]++;
+        }
+    }
+
+    for (auto& [key, count] : edgeUse) {
+        if (count == 1) {
+            locked[key >> 32] = true;
+            locked[key & 0xFFFFFFFF] = true;
+        }
+    }
+
+    // Seams, welded meshes only keep position duplicates where some other attribute differs
+    std::map<std::tuple<float, float, float>, uint32_t> positionUse;
+
+    for (const auto& v : vertices) {
+        positionUse[{v.pos.x, v.pos.y, v.pos.z}]++;
+    }
+
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        const auto& p = vertices[i].pos;
+
+        if (positionUse[{p.x, p.y, p.z}] > 1) {
+            locked[i] = true;
+        }
+    }
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+    auto pushCollapse = [&](uint32_t from, uint32_t to) {
+        if (locked[from]) return;
+
+        Quadric q = quadrics[from];
+        q += quadrics[to];
+
+        heap.push({q.evaluate(vertices[to].pos), from, to, version[from], version[to]});
+    };
+
+    for (auto& [key, count] : edgeUse) {
+        uint32_t a = static_cast<uint32_t>(key >> 32);
+        uint32_t b = static_cast<uint32_t>(key & 0xFFFFFFFF);
+
+        pushCollapse(a, b);
+        pushCollapse(b, a);
+    }
+
+    double maxCost = 0.0;
+
+    while (aliveTris * 3 > targetIndexCount && !heap.empty()) {
+        Collapse c = heap.top();
+        heap.pop();
+
+        if (removed[c.from] || removed[c.to] ||
+            version[c.from] != c.fromVersion || version[c.to] != c.toVersion) {
+            continue;
+        }
+
+        // The edge has to still exist, and no remaining triangle around "from" may flip.
+        bool connected = false;
+        bool flips = false;
+
+        for (uint32_t t : vertexTris[c.from]) {
+            if (!triAlive[t]) continue;
+
+            uint32_t* tri = &tris[3 * t];
+
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                connected = true;
+                continue;
+            }
+
+            glm::vec3 p[3], q[3];
+
+            for (int k = 0; k < 3; k++) {
+                p[k] = vertices[tri[k]].pos;
+                q[k] = tri[k] == c.from ? vertices[c.to].pos : p[k];
+            }
+
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+
+            if (glm::dot(before, after) <= 0.f) {
+                flips = true;
+                break;
+            }
+        }
+
+        if (!connected || flips) {
+            continue;
+        }
+
+        // Collapse from -> to
+        for (uint32_t t : vertexTris[c.from]) {
+            if (!triAlive[t]) continue;
+
+            uint32_t* tri = &tris[3 * t];
+
+            for (int k = 0; k < 3; k++) {
+                if (tri[k] == c.from) tri[k] = c.to;
+            }
+
+            if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) {
+                triAlive[t] = false;
+                aliveTris--;
+            } else {
+                vertexTris[c.to].push_back(t);
+            }
+        }
+
+        vertexTris[c.from].clear();
+        removed[c.from] = true;
+
+        quadrics[c.to] += quadrics[c.from];
+        version[c.to]++;
+
+        maxCost = std::max(maxCost, c.cost);
+
+        // Drop dead triangles from the survivor and requeue its edges with the merged quadric
+        auto& around = vertexTris[c.to];
+        around.erase(std::remove_if(around.begin(), around.end(), [&](uint32_t t) { return !triAlive[t]; }), around.end());
+        std::sort(around.begin(), around.end());
+        around.erase(std::unique(around.begin(), around.end()), around.end());
+
+        for (uint32_t t : around) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t n = tris[3 * t + k];
+
+                if (n != c.to) {
+                    pushCollapse(c.to, n);
+                    pushCollapse(n, c.to);
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(aliveTris * 3);
+
+    for (uint32_t t = 0; t < triCount; t++) {
+        if (triAlive[t]) {
+            result.insert(result.end(), tris.begin() + 3 * t, tris.begin() + 3 * t + 3);
+        }
+    }
+
+    if (outError) {
+        *outError = static_cast<float>(std::sqrt(std::max(maxCost, 0.0)));
+    }
+
+    return result;
+}
@@ -0,0 +1,141 @@
+#include "ParallelRecorder.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "Trace.hpp"
+
+bool ParallelRecorder::init(vk::Device device, uint32_t queueFamily, uint32_t threadCount, uint32_t framesInFlight) {
+    m_device = device;
+    m_stopping = false;
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // Transient, every buffer is recorded once per use
+    vk::CommandPoolCreateInfo poolInfo(vk::CommandPoolCreateFlagBits::eTransient, queueFamily);
+
+    m_pools.resize(threadCount);
+    m_buffers.resize(threadCount);
+
+    for (uint32_t t = 0; t < threadCount; t++) {
+        for (uint32_t f = 0; f < framesInFlight; f++) {
+            vk::CommandPool pool = m_device.createCommandPool(poolInfo);
+
+            m_pools[t].push_back(pool);
+            m_buffers[t].push_back(m_device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(pool, vk::CommandBufferLevel::eSecondary, 1))[0]);
+        }
+    }
+
+    for (uint32_t t = 1; t < threadCount; t++) {
+        m_threads.emplace_back(&ParallelRecorder::workerLoop, this, t);
+    }
+
+    return true;
+}
+
+void ParallelRecorder::destroy() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+
+    for (std::thread& t : m_threads) {
+        t.join();
+    }
+
+    m_threads.clear();
+
+    // Frees the buffers as well
+    for (auto& pools : m_pools) {
+        for (vk::CommandPool pool : pools) {
+            m_device.destroyCommandPool(pool);
+        }
+    }
+
+    m_pools.clear();
+    m_buffers.clear();
+    m_recorded.clear();
+}
+
+const std::vector<vk::CommandBuffer>& ParallelRecorder::record(uint32_t frame, const vk::CommandBufferInheritanceInfo& inheritance,
+                                                               uint32_t chunkCount, const RecordFunction& recordChunk) {
+    chunkCount = std::min(chunkCount, threadCount());
+    m_recorded.assign(chunkCount, VK_NULL_HANDLE);
+
+    if (chunkCount == 0) {
+        return m_recorded;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_frame = frame;
+        m_inheritance = &inheritance;
+        m_chunkCount = chunkCount;
+        m_recordChunk = &recordChunk;
+        m_pending = chunkCount - 1;
+        m_generation++;
+    }
+
+    m_wake.notify_all();
+
+    // Calling thread takes chunk 0 rather than sitting idle
+    this->recordChunk(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+
+    return m_recorded;
+}
+
+void ParallelRecorder::recordChunk(uint32_t thread) {
+    ATOM3D_TRACE_SCOPE("recordChunk");
+
+    // Whatever this thread recorded for this frame last time around is done executing
+    m_device.resetCommandPool(m_pools[thread][m_frame]);
+
+    vk::CommandBuffer cb = m_buffers[thread][m_frame];
+
+    cb.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+                                        m_inheritance));
+    (*m_recordChunk)(cb, thread);
+    cb.end();
+
+    m_recorded[thread] = cb;
+}
+
+void ParallelRecorder::workerLoop(uint32_t thread) {
+    Trace::setThreadName("Recorder " + std::to_string(thread));
+
+    uint64_t seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_wake.wait(lock, [&]() { return m_stopping || m_generation != seen; });
+
+            if (m_stopping) {
+                return;
+            }
+
+            seen = m_generation;
+
+            if (thread >= m_chunkCount) {
+                continue;
+            }
+        }
+
+        recordChunk(thread);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (--m_pending == 0) {
+            m_done.notify_one();
+        }
+    }
+}
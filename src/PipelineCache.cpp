@@ -0,0 +1,153 @@
+#include "PipelineCache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x43503341;  // "A3PC"
+constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+// Keeps temp files of concurrent instances apart.
+static unsigned long processId() {
+#if defined(_WIN32)
+    return static_cast<unsigned long>(_getpid());
+#else
+    return static_cast<unsigned long>(getpid());
+#endif
+}
+
+// FNV-1a, catches truncated or otherwise damaged files before the driver sees them.
+static uint64_t hashBytes(const uint8_t* bytes, size_t size) {
+    uint64_t h = 14695981039346656037ull;
+
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ bytes[i]) * 1099511628211ull;
+    }
+
+    return h;
+}
+
+PipelineCache::FileHeader PipelineCache::expectedHeader() const {
+    FileHeader header = {};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.version = PIPELINE_CACHE_VERSION;
+    header.vendorID = m_properties.vendorID;
+    header.deviceID = m_properties.deviceID;
+    header.driverVersion = m_properties.driverVersion;
+    memcpy(header.pipelineCacheUUID, m_properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+
+    return header;
+}
+
+void PipelineCache::init(vk::Device device, const vk::PhysicalDeviceProperties& properties, const std::string& path) {
+    m_device = device;
+    m_properties = properties;
+    m_path = path;
+    m_loadedSize = 0;
+
+    std::vector<uint8_t> data;
+
+    std::ifstream file;
+
+    if (!m_path.empty()) {
+        file.open(m_path, std::ios::binary);
+    }
+
+    FileHeader header = {};
+
+    if (file.is_open() && file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        FileHeader expected = expectedHeader();
+
+        bool matches = header.magic == expected.magic && header.version == expected.version &&
+                       header.vendorID == expected.vendorID && header.deviceID == expected.deviceID &&
+                       header.driverVersion == expected.driverVersion &&
+                       memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+
+        // Size comes from the file as well, check it against what's actually there before allocating for it
+        std::error_code ec;
+        uintmax_t fileSize = std::filesystem::file_size(m_path, ec);
+        bool sizeFits = !ec && fileSize >= sizeof(header) && header.dataSize <= fileSize - sizeof(header);
+
+        if (matches) {
+            if (sizeFits) {
+                data.resize(header.dataSize);
+            }
+
+            if (!sizeFits || !file.read(reinterpret_cast<char*>(data.data()), data.size()) ||
+                hashBytes(data.data(), data.size()) != header.dataHash) {
+                std::cerr << "Pipeline cache " << m_path << " is damaged, starting over.\n";
+                data.clear();
+            }
+        } else {
+            // Driver update or different GPU, the old data is of no use
+            std::cerr << "Pipeline cache " << m_path << " was written for another device or driver, starting over.\n";
+        }
+    }
+
+    vk::PipelineCacheCreateInfo info({}, data.size(), data.data());
+
+    m_cache = m_device.createPipelineCache(info);
+    m_loadedSize = data.size();
+}
+
+void PipelineCache::destroy() {
+    m_device.destroyPipelineCache(m_cache);
+    m_cache = VK_NULL_HANDLE;
+}
+
+bool PipelineCache::save() {
+    if (m_path.empty() || !m_cache) {
+        return false;
+    }
+
+    std::vector<uint8_t> data = m_device.getPipelineCacheData(m_cache);
+
+    FileHeader header = expectedHeader();
+    header.dataSize = static_cast<uint32_t>(data.size());
+    header.dataHash = hashBytes(data.data(), data.size());
+
+    // Other instances may be reading the old file, they get either that or the new one in full. The temp file is
+    // per process, instances saving at the same time would otherwise write into and rename each other's file.
+    const std::string tmpPath = m_path + "." + std::to_string(processId()) + ".tmp";
+
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open()) {
+            std::cerr << "Failed to open " << tmpPath << " for writing.\n";
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        file.flush();
+
+        if (!file) {
+            std::cerr << "Failed to write " << tmpPath << ".\n";
+            file.close();
+
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, m_path, ec);
+
+    if (ec) {
+        std::cerr << "Failed to replace " << m_path << ": " << ec.message() << "\n";
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,103 @@
+#include "PipelineCompiler.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "Trace.hpp"
+
+void PipelineCompiler::init(PipelineStateCache& pipelines, uint32_t threadCount) {
+    m_pipelines = &pipelines;
+    m_stopping = false;
+
+    if (threadCount == 0) {
+        // hardware_concurrency() may be 0 if unknown, one worker at least
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    m_threads.reserve(threadCount);
+
+    for (uint32_t i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&PipelineCompiler::workerLoop, this, i);
+    }
+}
+
+void PipelineCompiler::destroy() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+
+    for (std::thread& t : m_threads) {
+        t.join();
+    }
+
+    m_threads.clear();
+}
+
+std::future<vk::Pipeline> PipelineCompiler::submit(std::function<vk::Pipeline()> job, CompilePriority priority) {
+    std::packaged_task<vk::Pipeline()> task(std::move(job));
+    std::future<vk::Pipeline> result = task.get_future();
+
+    if (m_threads.empty()) {
+        task();
+        return result;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (priority == CompilePriority::Critical) {
+            m_critical.push_back(std::move(task));
+        } else {
+            m_deferred.push_back(std::move(task));
+        }
+    }
+
+    m_wake.notify_one();
+
+    return result;
+}
+
+std::future<vk::Pipeline> PipelineCompiler::compile(const GraphicsPipelineDesc& desc, CompilePriority priority) {
+    return submit([pipelines = m_pipelines, desc]() {
+        ATOM3D_TRACE_SCOPE("compileGraphicsPipeline");
+        return pipelines->graphicsPipeline(desc);
+    }, priority);
+}
+
+std::future<vk::Pipeline> PipelineCompiler::compile(const ComputePipelineDesc& desc, CompilePriority priority) {
+    return submit([pipelines = m_pipelines, desc]() {
+        ATOM3D_TRACE_SCOPE("compileComputePipeline");
+        return pipelines->computePipeline(desc);
+    }, priority);
+}
+
+void PipelineCompiler::workerLoop(uint32_t index) {
+    Trace::setThreadName("Pipeline compiler " + std::to_string(index));
+
+    for (;;) {
+        std::packaged_task<vk::Pipeline()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_wake.wait(lock, [this]() { return m_stopping || !m_critical.empty() || !m_deferred.empty(); });
+
+            // Queued jobs still run when stopping, their futures may be waited on
+            if (!m_critical.empty()) {
+                task = std::move(m_critical.front());
+                m_critical.pop_front();
+            } else if (!m_deferred.empty()) {
+                task = std::move(m_deferred.front());
+                m_deferred.pop_front();
+            } else {
+                return;
+            }
+        }
+
+        // Exceptions end up in the task's future
+        task();
+    }
+}
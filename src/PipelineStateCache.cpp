@@ -0,0 +1,497 @@
+#include "PipelineStateCache.hpp"
+
+#include <functional>
+#include <iostream>
+#include <memory>
+
+template <typename Handle>
+static uint64_t handleBits(Handle handle) {
+    return (uint64_t)(static_cast<typename Handle::CType>(handle));
+}
+
+template <typename Flags>
+static uint64_t flagBits(Flags flags) {
+    return static_cast<uint64_t>(static_cast<typename Flags::MaskType>(flags));
+}
+
+void hashCombine(size_t& seed, uint64_t value) {
+    seed ^= std::hash<uint64_t>()(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+// FNV-1a
+uint64_t hashShaderCode(const void* code, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(code);
+    uint64_t h = 14695981039346656037ull;
+
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ bytes[i]) * 1099511628211ull;
+    }
+
+    return h;
+}
+
+static ShaderStageDesc shaderStage(vk::ShaderStageFlagBits stage, const std::vector<char>& code) {
+    ShaderStageDesc s;
+    s.stage = stage;
+    s.codeHash = hashShaderCode(code.data(), code.size());
+    s.code = std::make_shared<const std::vector<char>>(code);
+
+    return s;
+}
+
+static void hashStage(size_t& h, const ShaderStageDesc& stage) {
+    hashCombine(h, static_cast<uint64_t>(stage.stage));
+    hashCombine(h, stage.codeHash);
+    hashCombine(h, stage.code ? stage.code->size() : 0);
+
+    for (const auto& e : stage.specEntries) {
+        hashCombine(h, e.constantID);
+        hashCombine(h, e.offset);
+    }
+
+    hashCombine(h, hashShaderCode(stage.specData.data(), stage.specData.size()));
+}
+
+static vk::ShaderModuleCreateInfo shaderModuleInfo(const ShaderStageDesc& stage) {
+    return vk::ShaderModuleCreateInfo({}, stage.code->size(), reinterpret_cast<const uint32_t*>(stage.code->data()));
+}
+
+static vk::SpecializationInfo specializationInfo(const ShaderStageDesc& stage) {
+    return vk::SpecializationInfo(stage.specEntries, vk::ArrayProxyNoTemporaries<const uint8_t>(stage.specData));
+}
+
+DescriptorSetLayoutDesc& DescriptorSetLayoutDesc::addBinding(uint32_t binding, vk::DescriptorType type, uint32_t count,
+                                                             vk::ShaderStageFlags stages, vk::DescriptorBindingFlags flags) {
+    // Binding flags are all or nothing, the earlier bindings get none
+    if (flags || !bindingFlags.empty()) {
+        bindingFlags.resize(bindings.size());
+        bindingFlags.push_back(flags);
+    }
+
+    bindings.push_back(vk::DescriptorSetLayoutBinding(binding, type, count, stages));
+
+    return *this;
+}
+
+size_t DescriptorSetLayoutDesc::hash() const {
+    size_t h = 0;
+    hashCombine(h, flagBits(flags));
+
+    for (const auto& b : bindings) {
+        hashCombine(h, b.binding);
+        hashCombine(h, static_cast<uint64_t>(b.descriptorType));
+        hashCombine(h, b.descriptorCount);
+        hashCombine(h, flagBits(b.stageFlags));
+    }
+
+    for (const auto& f : bindingFlags) {
+        hashCombine(h, flagBits(f));
+    }
+
+    return h;
+}
+
+bool DescriptorSetLayoutDesc::operator==(const DescriptorSetLayoutDesc& other) const {
+    return flags == other.flags && bindings == other.bindings && bindingFlags == other.bindingFlags;
+}
+
+PipelineLayoutDesc& PipelineLayoutDesc::addSetLayout(vk::DescriptorSetLayout layout) {
+    setLayouts.push_back(layout);
+    return *this;
+}
+
+PipelineLayoutDesc& PipelineLayoutDesc::addPushConstants(vk::ShaderStageFlags stages, uint32_t offset, uint32_t size) {
+    pushConstants.push_back(vk::PushConstantRange(stages, offset, size));
+    return *this;
+}
+
+size_t PipelineLayoutDesc::hash() const {
+    size_t h = 0;
+
+    for (const auto& l : setLayouts) {
+        hashCombine(h, handleBits(l));
+    }
+
+    for (const auto& p : pushConstants) {
+        hashCombine(h, flagBits(p.stageFlags));
+        hashCombine(h, p.offset);
+        hashCombine(h, p.size);
+    }
+
+    return h;
+}
+
+bool PipelineLayoutDesc::operator==(const PipelineLayoutDesc& other) const {
+    return setLayouts == other.setLayouts && pushConstants == other.pushConstants;
+}
+
+GraphicsPipelineDesc& GraphicsPipelineDesc::addStage(vk::ShaderStageFlagBits stage, const std::vector<char>& code) {
+    stages.push_back(shaderStage(stage, code));
+    return *this;
+}
+
+GraphicsPipelineDesc& GraphicsPipelineDesc::setVertexInput(std::vector<vk::VertexInputBindingDescription> bindings,
+                                                           std::vector<vk::VertexInputAttributeDescription> attributes) {
+    vertexBindings = std::move(bindings);
+    vertexAttributes = std::move(attributes);
+    return *this;
+}
+
+GraphicsPipelineDesc& GraphicsPipelineDesc::setRasterizer(vk::PolygonMode polygon, vk::CullModeFlags cull, vk::FrontFace front) {
+    polygonMode = polygon;
+    cullMode = cull;
+    frontFace = front;
+    return *this;
+}
+
+GraphicsPipelineDesc& GraphicsPipelineDesc::setLayout(vk::PipelineLayout pipelineLayout) {
+    layout = pipelineLayout;
+    return *this;
+}
+
+GraphicsPipelineDesc& GraphicsPipelineDesc::setRenderPass(vk::RenderPass pass, uint32_t subpassIndex) {
+    renderPass = pass;
+    subpass = subpassIndex;
+    return *this;
+}
+
+GraphicsPipelineDesc& GraphicsPipelineDesc::setColorFormat(vk::Format format) {
+    colorFormat = format;
+    return *this;
+}
+
+size_t GraphicsPipelineDesc::hash() const {
+    size_t h = 0;
+
+    for (const auto& s : stages) {
+        hashStage(h, s);
+    }
+
+    for (const auto& b : vertexBindings) {
+        hashCombine(h, b.binding);
+        hashCombine(h, b.stride);
+        hashCombine(h, static_cast<uint64_t>(b.inputRate));
+    }
+
+    for (const auto& a : vertexAttributes) {
+        hashCombine(h, a.location);
+        hashCombine(h, a.binding);
+        hashCombine(h, static_cast<uint64_t>(a.format));
+        hashCombine(h, a.offset);
+    }
+
+    hashCombine(h, static_cast<uint64_t>(topology));
+    hashCombine(h, static_cast<uint64_t>(polygonMode));
+    hashCombine(h, flagBits(cullMode));
+    hashCombine(h, static_cast<uint64_t>(frontFace));
+    hashCombine(h, blendEnable);
+    hashCombine(h, handleBits(layout));
+    hashCombine(h, handleBits(renderPass));
+    hashCombine(h, subpass);
+    hashCombine(h, static_cast<uint64_t>(colorFormat));
+
+    return h;
+}
+
+bool GraphicsPipelineDesc::operator==(const GraphicsPipelineDesc& other) const {
+    return stages == other.stages && vertexBindings == other.vertexBindings && vertexAttributes == other.vertexAttributes &&
+           topology == other.topology && polygonMode == other.polygonMode && cullMode == other.cullMode &&
+           frontFace == other.frontFace && blendEnable == other.blendEnable && layout == other.layout &&
+           renderPass == other.renderPass && subpass == other.subpass && colorFormat == other.colorFormat;
+}
+
+ComputePipelineDesc& ComputePipelineDesc::setShader(const std::vector<char>& code) {
+    stage = shaderStage(vk::ShaderStageFlagBits::eCompute, code);
+    return *this;
+}
+
+ComputePipelineDesc& ComputePipelineDesc::setLayout(vk::PipelineLayout pipelineLayout) {
+    layout = pipelineLayout;
+    return *this;
+}
+
+size_t ComputePipelineDesc::hash() const {
+    size_t h = 0;
+    hashStage(h, stage);
+    hashCombine(h, handleBits(layout));
+
+    return h;
+}
+
+bool ComputePipelineDesc::operator==(const ComputePipelineDesc& other) const {
+    return stage == other.stage && layout == other.layout;
+}
+
+void PipelineStateCache::init(vk::Device device, vk::PipelineCache vkCache) {
+    m_device = device;
+    m_vkCache = vkCache;
+}
+
+void PipelineStateCache::destroy() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& [desc, pipeline] : m_graphicsPipelines) {
+        m_device.destroyPipeline(pipeline);
+    }
+
+    for (auto& [desc, pipeline] : m_computePipelines) {
+        m_device.destroyPipeline(pipeline);
+    }
+
+    for (auto& [desc, layout] : m_pipelineLayouts) {
+        m_device.destroyPipelineLayout(layout);
+    }
+
+    for (auto& [desc, layout] : m_setLayouts) {
+        m_device.destroyDescriptorSetLayout(layout);
+    }
+
+    m_graphicsPipelines.clear();
+    m_computePipelines.clear();
+    m_pipelineLayouts.clear();
+    m_setLayouts.clear();
+}
+
+vk::DescriptorSetLayout PipelineStateCache::descriptorSetLayout(const DescriptorSetLayoutDesc& desc) {
+    // Cheap to create, fine under the lock
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_setLayouts.find(desc);
+
+    if (it != m_setLayouts.end()) {
+        return it->second;
+    }
+
+    vk::DescriptorSetLayoutCreateInfo info(desc.flags, desc.bindings);
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo flagsInfo(desc.bindingFlags);
+
+    if (!desc.bindingFlags.empty()) {
+        info.setPNext(&flagsInfo);
+    }
+
+    vk::DescriptorSetLayout layout = m_device.createDescriptorSetLayout(info);
+    m_setLayouts.emplace(desc, layout);
+
+    return layout;
+}
+
+vk::PipelineLayout PipelineStateCache::pipelineLayout(const PipelineLayoutDesc& desc) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_pipelineLayouts.find(desc);
+
+    if (it != m_pipelineLayouts.end()) {
+        return it->second;
+    }
+
+    vk::PipelineLayout layout = m_device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, desc.setLayouts, desc.pushConstants));
+    m_pipelineLayouts.emplace(desc, layout);
+
+    return layout;
+}
+
+template <typename Desc>
+vk::Pipeline PipelineStateCache::insertPipeline(std::unordered_map<Desc, vk::Pipeline, DescHash<Desc>>& map, Desc desc, vk::Pipeline created) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto [it, inserted] = map.emplace(std::move(desc), created);
+
+    if (!inserted) {
+        m_device.destroyPipeline(created);
+    }
+
+    return it->second;
+}
+
+vk::Pipeline PipelineStateCache::graphicsPipeline(const GraphicsPipelineDesc& desc) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_graphicsPipelines.find(desc);
+
+        if (it != m_graphicsPipelines.end()) {
+            return it->second;
+        }
+    }
+
+    vk::Pipeline created = createGraphicsPipeline(desc);
+
+    if (!created) {
+        return VK_NULL_HANDLE;
+    }
+
+    return insertPipeline(m_graphicsPipelines, desc, created);
+}
+
+vk::Pipeline PipelineStateCache::computePipeline(const ComputePipelineDesc& desc) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_computePipelines.find(desc);
+
+        if (it != m_computePipelines.end()) {
+            return it->second;
+        }
+    }
+
+    vk::Pipeline created = createComputePipeline(desc);
+
+    if (!created) {
+        return VK_NULL_HANDLE;
+    }
+
+    return insertPipeline(m_computePipelines, desc, created);
+}
+
+bool PipelineStateCache::release(vk::Pipeline pipeline) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_graphicsPipelines.begin(); it != m_graphicsPipelines.end(); ++it) {
+        if (it->second == pipeline) {
+            m_graphicsPipelines.erase(it);
+            return true;
+        }
+    }
+
+    for (auto it = m_computePipelines.begin(); it != m_computePipelines.end(); ++it) {
+        if (it->second == pipeline) {
+            m_computePipelines.erase(it);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t PipelineStateCache::pipelineCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_graphicsPipelines.size() + m_computePipelines.size();
+}
+
+vk::Pipeline PipelineStateCache::createGraphicsPipeline(const GraphicsPipelineDesc& desc) const {
+    std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
+
+    // Stages point into these, no reallocation
+    std::vector<vk::SpecializationInfo> specInfos;
+    specInfos.reserve(desc.stages.size());
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo({}, desc.vertexBindings, desc.vertexAttributes);
+
+    vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo({}, desc.topology, false);
+
+    // Both dynamic, only the counts matter
+    vk::PipelineViewportStateCreateInfo viewportInfo({}, 1, nullptr, 1, nullptr);
+
+    vk::PipelineRasterizationStateCreateInfo rasterizer({}, false, false,
+                                                        desc.polygonMode,
+                                                        desc.cullMode,
+                                                        desc.frontFace,
+                                                        false, 0.0, 0.0, 0.0, 1.0);
+
+    vk::PipelineMultisampleStateCreateInfo multisampling;
+
+    vk::PipelineColorBlendAttachmentState colorblendAttachment;
+    colorblendAttachment.colorWriteMask = vk::FlagTraits<vk::ColorComponentFlagBits>::allFlags;
+    colorblendAttachment.blendEnable = desc.blendEnable;
+
+    if (desc.blendEnable) {
+        colorblendAttachment.setSrcColorBlendFactor(vk::BlendFactor::eSrcAlpha)
+            .setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha)
+            .setColorBlendOp(vk::BlendOp::eAdd)
+            .setSrcAlphaBlendFactor(vk::BlendFactor::eOne)
+            .setDstAlphaBlendFactor(vk::BlendFactor::eZero)
+            .setAlphaBlendOp(vk::BlendOp::eAdd);
+    }
+
+    vk::PipelineColorBlendStateCreateInfo colorblendInfo;
+    colorblendInfo.setLogicOpEnable(false)
+        .setLogicOp(vk::LogicOp::eCopy)
+        .setAttachmentCount(1)
+        .setPAttachments(&colorblendAttachment);
+
+    std::vector<vk::DynamicState> dynStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+
+    vk::PipelineDynamicStateCreateInfo dynamicInfo({}, dynStates);
+
+    vk::PipelineRenderingCreateInfo renderingCreateInfo;
+    renderingCreateInfo.setColorAttachmentCount(1)
+        .setPColorAttachmentFormats(&desc.colorFormat);
+
+    vk::GraphicsPipelineCreateInfo pipeInfo;
+    pipeInfo.setPVertexInputState(&vertexInputInfo)
+        .setPInputAssemblyState(&inputAssemblyInfo)
+        .setPViewportState(&viewportInfo)
+        .setPRasterizationState(&rasterizer)
+        .setPMultisampleState(&multisampling)
+        .setPColorBlendState(&colorblendInfo)
+        .setPDynamicState(&dynamicInfo)
+        .setLayout(desc.layout)
+        .setRenderPass(desc.renderPass)
+        .setSubpass(desc.subpass);
+
+    if (!desc.renderPass) {
+        pipeInfo.setPNext(&renderingCreateInfo);
+    }
+
+    vk::Pipeline pipeline;
+
+    // Broken shaders (hot reload) shouldn't take the app down
+    try {
+        for (const ShaderStageDesc& s : desc.stages) {
+            specInfos.push_back(specializationInfo(s));
+
+            vk::ShaderModule module = m_device.createShaderModule(shaderModuleInfo(s));
+            shaderStages.push_back(vk::PipelineShaderStageCreateInfo({}, s.stage, module, "main", &specInfos.back()));
+        }
+
+        pipeInfo.setStages(shaderStages);
+
+        auto tmp = m_device.createGraphicsPipeline(m_vkCache, pipeInfo);
+
+        if (tmp.result == vk::Result::eSuccess) {
+            pipeline = tmp.value;
+        }
+    } catch (const vk::SystemError& e) {
+        std::cerr << e.what() << "\n";
+    }
+
+    if (!pipeline) {
+        std::cerr << "Failed to create graphics pipeline.\n";
+    }
+
+    for (const auto& s : shaderStages) {
+        m_device.destroyShaderModule(s.module);
+    }
+
+    return pipeline;
+}
+
+vk::Pipeline PipelineStateCache::createComputePipeline(const ComputePipelineDesc& desc) const {
+    vk::ShaderModule module;
+    vk::Pipeline pipeline;
+
+    try {
+        module = m_device.createShaderModule(shaderModuleInfo(desc.stage));
+
+        vk::SpecializationInfo specInfo = specializationInfo(desc.stage);
+
+        vk::PipelineShaderStageCreateInfo stage({}, vk::ShaderStageFlagBits::eCompute, module, "main", &specInfo);
+
+        auto tmp = m_device.createComputePipeline(m_vkCache, vk::ComputePipelineCreateInfo({}, stage, desc.layout));
+
+        if (tmp.result == vk::Result::eSuccess) {
+            pipeline = tmp.value;
+        }
+    } catch (const vk::SystemError& e) {
+        std::cerr << e.what() << "\n";
+    }
+
+    if (!pipeline) {
+        std::cerr << "Failed to create compute pipeline.\n";
+    }
+
+    m_device.destroyShaderModule(module);
+
+    return pipeline;
+}
@@ -1,7 +1,283 @@
 #include "Scene.hpp"
 
+#include <algorithm>
 #include <iostream>
 
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Trace.hpp"
+
+/// @brief Every mesh's LOD 0 indices followed by its other LODs, in mesh order.
+template <typename T>
+static std::vector<T> packIndices(const std::vector<Mesh>& meshes, size_t totalIndices) {
+    std::vector<T> indices;
+    indices.reserve(totalIndices);
+
+    for (const Mesh& mesh : meshes) {
+        indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+
+        for (const MeshLod& lod : mesh.lods) {
+            indices.insert(indices.end(), lod.indices.begin(), lod.indices.end());
+        }
+    }
+
+    return indices;
+}
+
+/// @brief Packs the vertices/indices of every mesh into one shared vertex buffer and one shared index buffer.
+/// Copies go through the transfer queue, the caller flushes them.
+/// @param allocator
+/// @param transfer
+void Scene::uploadMeshes(vma::Allocator& allocator, TransferQueue& transfer) {
+    ATOM3D_TRACE_SCOPE("uploadMeshes");
+
+    // "Import", meshes are welded (soups get their index buffer here) and the ones big enough get a LOD chain
+    // before they're packed.
+    {
+        ATOM3D_TRACE_SCOPE("weldVertices");
+
+        for (Mesh& mesh : meshes) {
+            mesh.weldVertices();
+        }
+    }
+
+    if (generateLods) {
+        ATOM3D_TRACE_SCOPE("generateLods");
+
+        for (Mesh& mesh : meshes) {
+            if (mesh.lods.empty()) {
+                mesh.generateLods();
+            }
+        }
+    }
+
+    meshRanges.clear();
+    meshRanges.reserve(meshes.size());
+
+    // Indices are mesh local, so 16 bit works as long as every single mesh fits, no matter the total.
+    indexType = vk::IndexType::eUint16;
+
+    size_t totalVertices = 0;
+    size_t totalIndices = 0;
+
+    for (const Mesh& mesh : meshes) {
+        MeshRange range;
+        range.firstIndex = static_cast<uint32_t>(totalIndices);
+        range.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        range.vertexOffset = static_cast<int32_t>(totalVertices);
+        range.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+
+        totalVertices += mesh.vertices.size();
+        totalIndices += mesh.indices.size();
+
+        // LODs right behind LOD 0, sharing its vertices
+        range.lods.push_back({range.firstIndex, range.indexCount, 0.f});
+
+        for (const MeshLod& lod : mesh.lods) {
+            range.lods.push_back({static_cast<uint32_t>(totalIndices), static_cast<uint32_t>(lod.indices.size()), lod.error});
+            totalIndices += lod.indices.size();
+        }
+
+        meshRanges.push_back(range);
+
+        if (mesh.indexType() == vk::IndexType::eUint32) {
+            indexType = vk::IndexType::eUint32;
+        }
+    }
+
+    if (totalVertices == 0 || totalIndices == 0) {
+        return;
+    }
+
+    vk::BufferUsageFlags vbufUsage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+    if (vertexFormat == VertexFormat::Float32) {
+        std::vector<Vertex> vertices;
+        vertices.reserve(totalVertices);
+
+        for (const Mesh& mesh : meshes) {
+            vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        }
+
+        vertexBuffer = transfer.createBuffer(vertices.data(), sizeof(Vertex) * vertices.size(), vbufUsage);
+    } else {
+        std::vector<PackedVertex> vertices;
+        vertices.reserve(totalVertices);
+
+        for (size_t i = 0; i < meshes.size(); i++) {
+            meshRanges[i].dequant = meshes[i].quantize(vertexFormat, vertices);
+        }
+
+        vertexBuffer = transfer.createBuffer(vertices.data(), sizeof(PackedVertex) * vertices.size(), vbufUsage);
+    }
+
+    vk::BufferUsageFlags ibufUsage = vk::BufferUsageFlagBits::eIndexBuffer;
+
+    if (indexType == vk::IndexType::eUint16) {
+        std::vector<uint16_t> indices = packIndices<uint16_t>(meshes, totalIndices);
+
+        indexBuffer = transfer.createBuffer(indices.data(), sizeof(uint16_t) * indices.size(), ibufUsage);
+    } else {
+        std::vector<uint32_t> indices = packIndices<uint32_t>(meshes, totalIndices);
+
+        indexBuffer = transfer.createBuffer(indices.data(), sizeof(uint32_t) * indices.size(), ibufUsage);
+    }
+
+    // Culling inputs
+    if (instances.empty()) {
+        for (uint32_t i = 0; i < meshes.size(); i++) {
+            Instance inst;
+            inst.mesh = i;
+            instances.push_back(inst);
+        }
+    }
+
+    if (materials.empty()) {
+        materials.push_back(Material());
+    }
+
+    std::stable_sort(instances.begin(), instances.end(), [](const Instance& a, const Instance& b) { return a.mesh < b.mesh; });
+
+    batches.clear();
+
+    for (uint32_t i = 0; i < instances.size(); i++) {
+        if (batches.empty() || batches.back().mesh != instances[i].mesh) {
+            InstanceBatch batch;
+            batch.mesh = instances[i].mesh;
+            batch.firstInstance = i;
+            batches.push_back(batch);
+        }
+
+        batches.back().instanceCount++;
+    }
+
+    std::vector<GpuMeshInfo> meshInfos(meshes.size());
+
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const MeshRange& range = meshRanges[i];
+        GpuMeshInfo& info = meshInfos[i];
+
+        info = {};
+        info.vertexOffset = range.vertexOffset;
+        info.lodCount = static_cast<uint32_t>(std::min<size_t>(range.lods.size(), MAX_MESH_LODS));
+        info.sphere = meshes[i].boundingSphere();
+        info.dequantScale = glm::vec4(range.dequant.scale, 0.f);
+        info.dequantOffset = glm::vec4(range.dequant.offset, 0.f);
+
+        for (uint32_t l = 0; l < info.lodCount; l++) {
+            info.lods[l] = {range.lods[l].firstIndex, range.lods[l].indexCount, range.lods[l].error, 0};
+        }
+    }
+
+    // Batches spread as evenly as possible over the chunks, every chunk's draws right after the previous one's
+    const uint32_t batchCount = static_cast<uint32_t>(batches.size());
+    const uint32_t chunkCount = std::max(1u, std::min(drawChunkCount, batchCount));
+
+    drawChunks.assign(chunkCount, DrawChunk());
+
+    std::vector<GpuBatch> gpuBatches(batches.size());
+    std::vector<GpuInstance> gpuInstances(instances.size());
+
+    for (uint32_t b = 0; b < batches.size(); b++) {
+        uint32_t chunk = static_cast<uint32_t>(uint64_t(b) * chunkCount / batchCount);
+        drawChunks[chunk].maxDrawCount += MAX_MESH_LODS;
+
+        gpuBatches[b] = {batches[b].mesh, batches[b].firstInstance, batches[b].instanceCount, chunk, 0, {0, 0, 0}};
+
+        for (uint32_t i = batches[b].firstInstance; i < batches[b].firstInstance + batches[b].instanceCount; i++) {
+            gpuInstances[i].transform = instances[i].transform;
+            gpuInstances[i].color = instances[i].color;
+            gpuInstances[i].batch = b;
+            gpuInstances[i].material = std::min<uint32_t>(instances[i].material, static_cast<uint32_t>(materials.size()) - 1);
+        }
+    }
+
+    for (uint32_t c = 1; c < chunkCount; c++) {
+        drawChunks[c].firstDraw = drawChunks[c - 1].firstDraw + drawChunks[c - 1].maxDrawCount;
+    }
+
+    for (GpuBatch& batch : gpuBatches) {
+        batch.chunkFirstDraw = drawChunks[batch.drawChunk].firstDraw;
+    }
+
+    std::vector<GpuMaterial> gpuMaterials(materials.size());
+
+    for (size_t m = 0; m < materials.size(); m++) {
+        gpuMaterials[m] = {materials[m].baseColor, materials[m].texture, materials[m].sampler, {0, 0}};
+    }
+
+    meshInfoBuffer = transfer.createBuffer(meshInfos.data(), sizeof(GpuMeshInfo) * meshInfos.size(), vk::BufferUsageFlagBits::eStorageBuffer);
+
+    batchBuffer = transfer.createBuffer(gpuBatches.data(), sizeof(GpuBatch) * gpuBatches.size(), vk::BufferUsageFlagBits::eStorageBuffer);
+
+    instanceBuffer = transfer.createBuffer(gpuInstances.data(), sizeof(GpuInstance) * gpuInstances.size(), vk::BufferUsageFlagBits::eStorageBuffer);
+
+    materialBuffer = transfer.createBuffer(gpuMaterials.data(), sizeof(GpuMaterial) * gpuMaterials.size(), vk::BufferUsageFlagBits::eStorageBuffer);
+
+    // Culling outputs, sized for the worst case of everything being visible. Every (batch, LOD) might get a draw.
+    maxDrawCount = static_cast<uint32_t>(batches.size()) * MAX_MESH_LODS;
+
+    batchCountBuffer = AllocatedBuffer::createBuffer(allocator, sizeof(uint32_t) * maxDrawCount,
+                                                     vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                                     vma::MemoryUsage::eAutoPreferDevice, {});
+
+    instanceSlotBuffer = AllocatedBuffer::createBuffer(allocator, sizeof(uint32_t) * instances.size(), vk::BufferUsageFlagBits::eStorageBuffer,
+                                                       vma::MemoryUsage::eAutoPreferDevice, {});
+
+    // Every instance picks a single LOD, the LODs of a batch split its instance range between them
+    visibleInstanceBuffer = AllocatedBuffer::createBuffer(allocator, sizeof(InstanceVertex) * instances.size(),
+                                                          vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer |
+                                                              vk::BufferUsageFlagBits::eShaderDeviceAddress,
+                                                          vma::MemoryUsage::eAutoPreferDevice, {});
+
+    indirectBuffer = AllocatedBuffer::createBuffer(allocator, sizeof(vk::DrawIndexedIndirectCommand) * maxDrawCount,
+                                                   vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+                                                   vma::MemoryUsage::eAutoPreferDevice, {});
+
+    countBuffer = AllocatedBuffer::createBuffer(allocator, sizeof(uint32_t) * chunkCount,
+                                                vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+                                                    vk::BufferUsageFlagBits::eTransferDst,
+                                                vma::MemoryUsage::eAutoPreferDevice, {});
+}
+
+void Scene::addInstances(uint32_t mesh, const std::vector<glm::mat4>& transforms, glm::vec4 color, uint32_t material) {
+    instances.reserve(instances.size() + transforms.size());
+
+    for (const auto& t : transforms) {
+        Instance inst;
+        inst.transform = t;
+        inst.color = color;
+        inst.mesh = mesh;
+        inst.material = material;
+
+        instances.push_back(inst);
+    }
+}
+
+void Scene::destroyBuffers(vma::Allocator& allocator) {
+    if (vertexBuffer.buffer) {
+        allocator.destroyBuffer(vertexBuffer.buffer, vertexBuffer.allocation);
+    }
+
+    if (indexBuffer.buffer) {
+        allocator.destroyBuffer(indexBuffer.buffer, indexBuffer.allocation);
+    }
+
+    for (AllocatedBuffer* b : {&instanceBuffer, &meshInfoBuffer, &batchBuffer, &materialBuffer, &batchCountBuffer,
+                               &instanceSlotBuffer, &visibleInstanceBuffer, &indirectBuffer, &countBuffer}) {
+        if (b->buffer) {
+            allocator.destroyBuffer(b->buffer, b->allocation);
+        }
+
+        *b = {};
+    }
+
+    vertexBuffer = {};
+    indexBuffer = {};
+    maxDrawCount = 0;
+    drawChunks.clear();
+}
+
 MainScene::MainScene() {
     Mesh triangle;
 
@@ -10,32 +286,135 @@ MainScene::MainScene() {
     meshes.push_back(triangle);
 }
 
-// TODO: Make this more modular
-/// @brief Creates a Buffer for scene meshes, stores mesh vertices/indices in it.
-/// @param allocator
-/// @param commandBuffer
-/// @param subQueue
-void MainScene::uploadMeshes(vma::Allocator& allocator, vk::CommandBuffer commandBuffer, vk::Queue subQueue) {
-    float vertexBufferSize = sizeof(Vertex) * meshes[0].vertices.size();
+GridScene::GridScene(uint32_t side) {
+    Mesh base;
+    Mesh::triangle(base);
+
+    // Cells span clip space. Each cell bakes its placement into its own copy of the triangle instead of sharing one
+    // mesh through instance transforms (InstancedScene does that), so every cell costs a mesh, a batch and a draw.
+    const float cell = 2.f / side;
 
-    // Create Staging Buffer
-    vk::BufferUsageFlags stgbufUsage = vk::BufferUsageFlagBits::eTransferSrc;
+    meshes.reserve(side * side);
 
-    auto [stagingBuffer, stgAlloc] = AllocatedBuffer::createBuffer(allocator, vertexBufferSize, stgbufUsage, vma::MemoryUsage::eAuto);
+    for (uint32_t y = 0; y < side; y++) {
+        for (uint32_t x = 0; x < side; x++) {
+            Mesh m = base;
+            glm::vec3 center(-1.f + cell * (x + 0.5f), -1.f + cell * (y + 0.5f), 0.f);
 
-    void* mem = allocator.mapMemory(stgAlloc);
-    memcpy(mem, meshes[0].vertices.data(), vertexBufferSize);
-    allocator.unmapMemory(stgAlloc);
+            for (auto& v : m.vertices) {
+                v.pos = center + v.pos * (cell * 0.4f);
+            }
 
-    // Create Vertex/IndexBuffer (No index for now)
-    vk::BufferUsageFlags vbufUsage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer;
+            meshes.push_back(std::move(m));
+        }
+    }
+}
 
-    buffer = AllocatedBuffer::createBuffer(allocator, vertexBufferSize, vbufUsage, vma::MemoryUsage::eAuto);
+InstancedScene::InstancedScene(uint32_t side) {
+    Mesh triangle;
+    Mesh quad;
 
-    // Copy buffers
+    Mesh::triangle(triangle);
+    Mesh::quad(quad);
 
-    AllocatedBuffer::copyBuffer(stagingBuffer, buffer.buffer, vertexBufferSize, commandBuffer, subQueue);
+    meshes.push_back(triangle);
+    meshes.push_back(quad);
 
-    // Destroy Staging Buffer
-    allocator.destroyBuffer(stagingBuffer, stgAlloc);
-}
\ No newline at end of file
+    // Checkerboard of the two, nothing overlaps since there's no depth buffer and batch order isn't fixed.
+    const float cell = 2.f / side;
+
+    std::vector<glm::mat4> triangles;
+    std::vector<glm::mat4> quads;
+
+    triangles.reserve(side * side / 2 + 1);
+    quads.reserve(side * side / 2 + 1);
+
+    for (uint32_t y = 0; y < side; y++) {
+        for (uint32_t x = 0; x < side; x++) {
+            glm::vec3 center(-1.f + cell * (x + 0.5f), -1.f + cell * (y + 0.5f), 0.f);
+
+            glm::mat4 t = glm::scale(glm::translate(glm::mat4(1.f), center), glm::vec3(cell * 0.4f));
+
+            if ((x + y) % 2 == 0) {
+                triangles.push_back(t);
+            } else {
+                quads.push_back(t);
+            }
+        }
+    }
+
+    addInstances(0, triangles);
+    addInstances(1, quads, glm::vec4(0.2f, 0.6f, 0.2f, 1.f));
+}
+
+LodScene::LodScene(uint32_t count) {
+    Mesh sphere;
+    Mesh::sphere(sphere, 64, 128);
+
+    meshes.push_back(sphere);
+
+    // Rows of spheres going off into the distance, projection follows the render extent (see resize())
+    resize(800, 600);
+    camera.view = glm::lookAt(glm::vec3(0.f, 4.f, 8.f), glm::vec3(0.f, 0.f, -20.f), glm::vec3(0.f, 1.f, 0.f));
+
+    std::vector<glm::mat4> transforms;
+    transforms.reserve(count);
+
+    const uint32_t perRow = 16;
+
+    for (uint32_t i = 0; i < count; i++) {
+        glm::vec3 p(3.f * (float(i % perRow) - perRow / 2.f), 0.f, -3.f * float(i / perRow));
+        transforms.push_back(glm::translate(glm::mat4(1.f), p));
+    }
+
+    addInstances(0, transforms);
+}
+
+void LodScene::resize(uint32_t width, uint32_t height) {
+    if (width == 0 || height == 0) {
+        return;
+    }
+
+    camera.projection = glm::perspective(glm::radians(60.f), float(width) / float(height), 0.1f, 500.f);
+    // glm follows GL, clip space Y points up there and down in Vulkan
+    camera.projection[1][1] *= -1.f;
+}
+
+std::unique_ptr<Scene> createScene(const std::string& name) {
+    if (name == "main") {
+        return std::make_unique<MainScene>();
+    } else if (name == "grid") {
+        return std::make_unique<GridScene>(32);
+    } else if (name == "instanced") {
+        return std::make_unique<InstancedScene>(100);
+    } else if (name == "lod") {
+        return std::make_unique<LodScene>(2048);
+    }
+
+    return nullptr;
+}
+
+bool vertexFormatFromName(const std::string& name, VertexFormat& format) {
+    if (name == "float") {
+        format = VertexFormat::Float32;
+    } else if (name == "half") {
+        format = VertexFormat::Half;
+    } else if (name == "snorm16") {
+        format = VertexFormat::Snorm16;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+const char* vertexFormatName(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Half:
+            return "half";
+        case VertexFormat::Snorm16:
+            return "snorm16";
+        default:
+            return "float";
+    }
+}
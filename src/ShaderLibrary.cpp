@@ -0,0 +1,66 @@
+#include "ShaderLibrary.hpp"
+
+#include <cstring>
+#include <fstream>
+
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+/// @brief Reads a loose SPIR-V file, opened with std::ios::ate.
+/// @return false if the file can't be read or doesn't look like SPIR-V.
+static bool readSPV(std::ifstream& file, std::vector<char>& code) {
+    size_t fileSize = (size_t)file.tellg();
+
+    if (fileSize < 20 || fileSize % 4 != 0) {
+        return false;
+    }
+
+    code.resize(fileSize);
+
+    file.seekg(0);
+    file.read(code.data(), fileSize);
+
+    uint32_t magic;
+    memcpy(&magic, code.data(), sizeof(magic));
+
+    return file && magic == SPIRV_MAGIC;
+}
+
+const EmbeddedShader* findEmbeddedShader(const std::string& name) {
+    for (size_t i = 0; i < EMBEDDED_SHADER_COUNT; i++) {
+        if (name == EMBEDDED_SHADERS[i].name) {
+            return &EMBEDDED_SHADERS[i];
+        }
+    }
+
+    return nullptr;
+}
+
+void ShaderLibrary::init(const std::string& overrideDir) {
+    m_overrideDir = overrideDir;
+
+    if (!m_overrideDir.empty() && m_overrideDir.back() != '/' && m_overrideDir.back() != '\\') {
+        m_overrideDir += '/';
+    }
+}
+
+bool ShaderLibrary::load(const std::string& name, std::vector<char>& code) const {
+    if (!m_overrideDir.empty()) {
+        std::ifstream file(m_overrideDir + name, std::ios::ate | std::ios::binary);
+
+        // One that's there but broken is an error, quietly going back to the embedded copy would hide it
+        if (file.is_open()) {
+            return readSPV(file, code);
+        }
+    }
+
+    const EmbeddedShader* shader = findEmbeddedShader(name);
+
+    if (!shader) {
+        return false;
+    }
+
+    code.resize(shader->size);
+    memcpy(code.data(), shader->code, shader->size);
+
+    return true;
+}
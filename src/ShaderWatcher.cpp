@@ -0,0 +1,135 @@
+#include "ShaderWatcher.hpp"
+
+#include <iostream>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+bool ShaderWatcher::init(const std::string& directory) {
+    m_directory = directory;
+    m_changed.clear();
+
+#if defined(__linux__)
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (m_fd < 0) {
+        std::cerr << "inotify_init1 failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    // Written in place or renamed into place (glslc -o, most editors' safe writes)
+    m_watch = inotify_add_watch(m_fd, m_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+    if (m_watch < 0) {
+        std::cerr << "Failed to watch " << m_directory << ": " << strerror(errno) << "\n";
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+#else
+    std::error_code ec;
+
+    m_writeTimes.clear();
+
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory, ec)) {
+        m_writeTimes[entry.path().filename().string()] = entry.last_write_time(ec);
+    }
+
+    if (ec) {
+        std::cerr << "Failed to watch " << m_directory << ": " << ec.message() << "\n";
+        return false;
+    }
+
+    m_lastScan = std::chrono::steady_clock::now();
+#endif
+
+    m_active = true;
+
+    return true;
+}
+
+void ShaderWatcher::destroy() {
+#if defined(__linux__)
+    if (m_fd >= 0) {
+        close(m_fd);  // Drops the watch as well
+    }
+
+    m_fd = -1;
+    m_watch = -1;
+#else
+    m_writeTimes.clear();
+#endif
+
+    m_changed.clear();
+    m_active = false;
+}
+
+void ShaderWatcher::gatherChanges() {
+    auto now = std::chrono::steady_clock::now();
+
+#if defined(__linux__)
+    alignas(inotify_event) char buf[4096];
+
+    for (;;) {
+        ssize_t len = read(m_fd, buf, sizeof(buf));
+
+        if (len <= 0) {
+            break;  // EAGAIN, nothing left
+        }
+
+        for (ssize_t i = 0; i < len;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buf + i);
+
+            if (event->len > 0) {
+                m_changed.insert(event->name);
+                m_lastChange = now;
+            }
+
+            i += sizeof(inotify_event) + event->len;
+        }
+    }
+#else
+    if (now - m_lastScan < SHADER_WATCH_SETTLE_TIME) {
+        return;
+    }
+
+    m_lastScan = now;
+
+    std::error_code ec;
+
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory, ec)) {
+        std::string name = entry.path().filename().string();
+        auto time = entry.last_write_time(ec);
+
+        auto it = m_writeTimes.find(name);
+
+        if (it == m_writeTimes.end() || it->second != time) {
+            m_writeTimes[name] = time;
+            m_changed.insert(name);
+            m_lastChange = now;
+        }
+    }
+#endif
+}
+
+std::vector<std::string> ShaderWatcher::poll() {
+    if (!m_active) {
+        return {};
+    }
+
+    gatherChanges();
+
+    if (m_changed.empty() || std::chrono::steady_clock::now() - m_lastChange < SHADER_WATCH_SETTLE_TIME) {
+        return {};
+    }
+
+    std::vector<std::string> changed(m_changed.begin(), m_changed.end());
+    m_changed.clear();
+
+    return changed;
+}
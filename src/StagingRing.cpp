@@ -0,0 +1,69 @@
+#include "StagingRing.hpp"
+
+#include <cstring>
+#include <iostream>
+
+bool StagingRing::init(vma::Allocator allocator, vk::DeviceSize size) {
+    m_allocator = allocator;
+    m_size = size;
+    m_head = 0;
+    m_tail = 0;
+
+    m_buffer = AllocatedBuffer::createBuffer(m_allocator, size, vk::BufferUsageFlagBits::eTransferSrc, vma::MemoryUsage::eAuto);
+
+    m_mapped = static_cast<uint8_t*>(m_allocator.getAllocationInfo(m_buffer.allocation).pMappedData);
+
+    if (!m_mapped) {
+        std::cerr << "Failed to map the staging ring.\n";
+        return false;
+    }
+
+    return true;
+}
+
+void StagingRing::destroy() {
+    if (m_buffer.buffer) {
+        m_allocator.destroyBuffer(m_buffer.buffer, m_buffer.allocation);
+    }
+
+    m_buffer = {};
+    m_mapped = nullptr;
+}
+
+bool StagingRing::push(const void* data, vk::DeviceSize size, vk::DeviceSize& offset) {
+    if (size > m_size) {
+        return false;
+    }
+
+    // Empty, start over at the beginning so a big allocation never has to wait on a partial lap
+    if (m_head == m_tail) {
+        m_head = m_tail = (m_head + m_size - 1) / m_size * m_size;
+    }
+
+    uint64_t start = (m_head + STAGING_RING_ALIGNMENT - 1) & ~(STAGING_RING_ALIGNMENT - 1);
+
+    // Allocations never straddle the end, skip what's left of this lap instead
+    if (start % m_size + size > m_size) {
+        start += m_size - start % m_size;
+    }
+
+    if (start + size - m_tail > m_size) {
+        return false;
+    }
+
+    offset = start % m_size;
+    m_head = start + size;
+
+    memcpy(m_mapped + offset, data, size);
+
+    // No-op on coherent memory
+    m_allocator.flushAllocation(m_buffer.allocation, offset, size);
+
+    return true;
+}
+
+void StagingRing::release(uint64_t marker) {
+    if (marker > m_tail) {
+        m_tail = marker;
+    }
+}
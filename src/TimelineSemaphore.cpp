@@ -0,0 +1,44 @@
+#include "TimelineSemaphore.hpp"
+
+#include <algorithm>
+
+bool TimelineSemaphore::init(vk::Device device) {
+    m_device = device;
+    m_lastSignaled = 0;
+    m_completed = 0;
+
+    vk::SemaphoreTypeCreateInfo typeInfo(vk::SemaphoreType::eTimeline, 0);
+    vk::SemaphoreCreateInfo info;
+    info.setPNext(&typeInfo);
+
+    m_semaphore = m_device.createSemaphore(info);
+
+    return m_semaphore != VK_NULL_HANDLE;
+}
+
+void TimelineSemaphore::destroy() {
+    m_device.destroySemaphore(m_semaphore);
+    m_semaphore = VK_NULL_HANDLE;
+}
+
+uint64_t TimelineSemaphore::completed() const {
+    m_completed = m_device.getSemaphoreCounterValue(m_semaphore);
+
+    return m_completed;
+}
+
+bool TimelineSemaphore::wait(uint64_t value, uint64_t timeout) const {
+    if (value <= m_completed) {
+        return true;
+    }
+
+    vk::SemaphoreWaitInfo info({}, m_semaphore, value);
+
+    if (m_device.waitSemaphores(info, timeout) != vk::Result::eSuccess) {
+        return false;
+    }
+
+    m_completed = std::max(m_completed, value);
+
+    return true;
+}
@@ -0,0 +1,138 @@
+#include "Trace.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct ThreadBuffer {
+    std::array<TraceEvent, TRACE_EVENTS_PER_THREAD> events;
+    std::atomic<uint64_t> head{0};  // Total events ever written, the ring index is head % TRACE_EVENTS_PER_THREAD
+    uint32_t tid = 0;
+    std::string name;
+};
+
+// Buffers are owned by the registry and not by the thread, so events of threads that already exited can
+// still be dumped.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+std::atomic<bool> g_enabled{false};
+
+const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+ThreadBuffer& threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+
+    if (!buffer) {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        r.buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = r.buffers.back().get();
+        buffer->tid = static_cast<uint32_t>(r.buffers.size());
+    }
+
+    return *buffer;
+}
+
+void writeEscaped(std::ostream& out, const std::string& str) {
+    for (char c : str) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+}
+
+}  // namespace
+
+void Trace::setEnabled(bool enabled) {
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Trace::enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void Trace::setThreadName(const std::string& name) {
+    ThreadBuffer& b = threadBuffer();
+
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    b.name = name;
+}
+
+uint64_t Trace::nowNs() {
+    // +1 so that a valid timestamp is never 0, TraceScope uses 0 for "not recording".
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count() + 1;
+}
+
+void Trace::record(const char* name, uint64_t startNs, uint64_t endNs) {
+    ThreadBuffer& b = threadBuffer();
+
+    uint64_t head = b.head.load(std::memory_order_relaxed);
+    b.events[head % TRACE_EVENTS_PER_THREAD] = {name, startNs, endNs};
+    b.head.store(head + 1, std::memory_order_release);
+}
+
+/// @brief Writes every buffered zone of every thread as Chrome trace event JSON.
+/// Threads keep recording while this runs, events being overwritten during the dump may come out torn,
+/// dump between frames if that matters.
+/// @param path
+bool Trace::dumpChromeJson(const std::string& path) {
+    std::ofstream file(path);
+
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << path << " for writing.\n";
+        return false;
+    }
+
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    // Timestamps are in microseconds, keep the nanoseconds.
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+    bool first = true;
+
+    for (auto& b : r.buffers) {
+        if (!b->name.empty()) {
+            file << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << b->tid
+                 << ", \"args\": {\"name\": \"";
+            writeEscaped(file, b->name);
+            file << "\"}}";
+            first = false;
+        }
+
+        uint64_t head = b->head.load(std::memory_order_acquire);
+        uint64_t begin = head > TRACE_EVENTS_PER_THREAD ? head - TRACE_EVENTS_PER_THREAD : 0;
+
+        for (uint64_t i = begin; i < head; i++) {
+            const TraceEvent& e = b->events[i % TRACE_EVENTS_PER_THREAD];
+
+            file << (first ? "" : ",\n") << "{\"name\": \"";
+            writeEscaped(file, e.name);
+            file << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << b->tid
+                 << ", \"ts\": " << e.startNs / 1000.0
+                 << ", \"dur\": " << (e.endNs - e.startNs) / 1000.0 << "}";
+            first = false;
+        }
+    }
+
+    file << "\n]}\n";
+
+    return true;
+}
@@ -0,0 +1,270 @@
+#include "TransferQueue.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include "Trace.hpp"
+
+bool TransferQueue::init(vk::Device device, const vkb::Device& vkbDevice, vma::Allocator allocator) {
+    m_device = device;
+    m_allocator = allocator;
+
+    auto graphicsFamily = vkbDevice.get_queue_index(vkb::QueueType::graphics);
+    if (!graphicsFamily) {
+        std::cerr << "Failed to find graphics queue family: " << graphicsFamily.error().message() << "\n";
+        return false;
+    }
+
+    m_graphicsFamily = graphicsFamily.value();
+
+    // Prefer a transfer only family (DMA engine), then any separate one with transfer support, then graphics.
+    auto tq = vkbDevice.get_dedicated_queue(vkb::QueueType::transfer);
+    auto ti = vkbDevice.get_dedicated_queue_index(vkb::QueueType::transfer);
+
+    if (!tq) {
+        tq = vkbDevice.get_queue(vkb::QueueType::transfer);
+        ti = vkbDevice.get_queue_index(vkb::QueueType::transfer);
+    }
+
+    if (tq && ti) {
+        m_queue = tq.value();
+        m_transferFamily = ti.value();
+    } else {
+        auto gq = vkbDevice.get_queue(vkb::QueueType::graphics);
+        if (!gq) {
+            std::cerr << "Failed to acquire graphics queue: " << gq.error().message() << "\n";
+            return false;
+        }
+
+        m_queue = gq.value();
+        m_transferFamily = m_graphicsFamily;
+    }
+
+    vk::CommandPoolCreateInfo info(vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+                                   m_transferFamily);
+
+    m_commandPool = m_device.createCommandPool(info);
+
+    return m_timeline.init(m_device) && m_ring.init(m_allocator);
+}
+
+void TransferQueue::destroy() {
+    // Only safe after the device went idle, everything counts as finished then.
+    if (m_recording) {
+        m_current.cb.end();
+        recycle(m_current);
+        m_free.push_back(std::move(m_current));
+        m_recording = false;
+    }
+
+    for (Batch& b : m_batches) {
+        recycle(b);
+        m_free.push_back(std::move(b));
+    }
+
+    m_batches.clear();
+
+    m_free.clear();
+
+    m_device.destroyCommandPool(m_commandPool);
+    m_commandPool = VK_NULL_HANDLE;
+
+    m_timeline.destroy();
+    m_ring.destroy();
+}
+
+TransferQueue::Batch& TransferQueue::recording() {
+    if (m_recording) {
+        return m_current;
+    }
+
+    if (!m_free.empty()) {
+        m_current = std::move(m_free.back());
+        m_free.pop_back();
+    } else {
+        m_current = Batch();
+        m_current.cb = m_device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(m_commandPool, vk::CommandBufferLevel::ePrimary, 1))[0];
+    }
+
+    m_current.cb.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    m_recording = true;
+
+    return m_current;
+}
+
+void TransferQueue::recycle(Batch& batch) {
+    for (AllocatedBuffer& s : batch.staging) {
+        m_allocator.destroyBuffer(s.buffer, s.allocation);
+    }
+
+    batch.staging.clear();
+    batch.acquires.clear();
+    batch.value = 0;
+    batch.acquired = false;
+    batch.stagingEnd = 0;
+}
+
+void TransferQueue::reclaimStaging() {
+    ATOM3D_TRACE_SCOPE("TransferQueue::reclaimStaging");
+
+    flush();
+
+    for (Batch& b : m_batches) {
+        if (!m_timeline.isDone(b.value)) {
+            m_timeline.wait(b.value);
+            break;
+        }
+    }
+
+    collect();
+}
+
+void TransferQueue::upload(vk::Buffer dst, vk::DeviceSize offset, const void* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    vk::Buffer src;
+    vk::DeviceSize srcOffset = 0;
+    AllocatedBuffer staging;
+
+    if (size > m_ring.capacity()) {
+        staging = AllocatedBuffer::createBuffer(m_allocator, size, vk::BufferUsageFlagBits::eTransferSrc, vma::MemoryUsage::eAuto);
+
+        void* mem = m_allocator.mapMemory(staging.allocation);
+        memcpy(mem, data, size);
+        m_allocator.unmapMemory(staging.allocation);
+
+        src = staging.buffer;
+    } else {
+        // Full, more than a ring's worth went up since the oldest pending batch. Level loads only.
+        while (!m_ring.push(data, size, srcOffset)) {
+            reclaimStaging();
+        }
+
+        src = m_ring.buffer();
+    }
+
+    Batch& batch = recording();
+
+    vk::BufferCopy region(srcOffset, offset, size);
+    batch.cb.copyBuffer(src, dst, region);
+
+    batch.stagingEnd = m_ring.head();
+
+    if (staging.buffer) {
+        batch.staging.push_back(staging);
+    }
+
+    // Release here, the matching acquire goes into the graphics command buffer. Without a family change the
+    // semaphore alone orders and makes the copy visible.
+    if (dedicated()) {
+        vk::BufferMemoryBarrier release(vk::AccessFlagBits::eTransferWrite, {}, m_transferFamily, m_graphicsFamily, dst, offset, size);
+
+        batch.cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+                                 {}, nullptr, release, nullptr);
+
+        vk::BufferMemoryBarrier acquire({}, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eIndirectCommandRead |
+                                            vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead,
+                                        m_transferFamily, m_graphicsFamily, dst, offset, size);
+
+        batch.acquires.push_back(acquire);
+    }
+}
+
+AllocatedBuffer TransferQueue::createBuffer(const void* data, size_t size, vk::BufferUsageFlags usage) {
+    AllocatedBuffer dst = AllocatedBuffer::createBuffer(m_allocator, size, usage | vk::BufferUsageFlagBits::eTransferDst,
+                                                        vma::MemoryUsage::eAutoPreferDevice, {});
+
+    upload(dst.buffer, 0, data, size);
+
+    return dst;
+}
+
+void TransferQueue::flush() {
+    if (!m_recording) {
+        return;
+    }
+
+    ATOM3D_TRACE_SCOPE("TransferQueue::flush");
+
+    m_current.cb.end();
+
+    m_current.value = m_timeline.nextValue();
+
+    vk::Semaphore signal = m_timeline.semaphore();
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo;
+    timelineInfo.setSignalSemaphoreValues(m_current.value);
+
+    vk::SubmitInfo subInfo;
+    subInfo.setCommandBuffers(m_current.cb)
+        .setSignalSemaphores(signal)
+        .setPNext(&timelineInfo);
+
+    m_queue.submit(subInfo, nullptr);
+
+    m_batches.push_back(std::move(m_current));
+    m_recording = false;
+}
+
+void TransferQueue::acquire(vk::CommandBuffer cb, std::vector<vk::Semaphore>& waitSemaphores, std::vector<vk::PipelineStageFlags>& waitStages,
+                            std::vector<uint64_t>& waitValues) {
+    std::vector<vk::BufferMemoryBarrier> acquires;
+    uint64_t newest = 0;
+
+    for (Batch& b : m_batches) {
+        if (b.acquired) {
+            continue;
+        }
+
+        acquires.insert(acquires.end(), b.acquires.begin(), b.acquires.end());
+        newest = b.value;
+
+        b.acquired = true;
+    }
+
+    if (newest == 0) {
+        return;
+    }
+
+    // Reaching the newest value implies all the older ones
+    waitSemaphores.push_back(m_timeline.semaphore());
+    waitStages.push_back(UPLOAD_CONSUMER_STAGES);
+    waitValues.push_back(newest);
+
+    if (!acquires.empty()) {
+        // Chains onto the semaphore wait, which covers the same stages.
+        cb.pipelineBarrier(UPLOAD_CONSUMER_STAGES, UPLOAD_CONSUMER_STAGES, {}, nullptr, acquires, nullptr);
+    }
+}
+
+void TransferQueue::collect() {
+    // Batches retire in submission order, the timeline passing one means every older one is done too.
+    // Staging only has to outlive the copies, even if no graphics submission picked the batch up yet.
+    for (Batch& b : m_batches) {
+        if (!m_timeline.isDone(b.value)) {
+            break;
+        }
+
+        m_ring.release(b.stagingEnd);
+
+        for (AllocatedBuffer& s : b.staging) {
+            m_allocator.destroyBuffer(s.buffer, s.allocation);
+        }
+
+        b.staging.clear();
+    }
+
+    while (!m_batches.empty()) {
+        Batch& b = m_batches.front();
+
+        if (!b.acquired || !m_timeline.isDone(b.value)) {
+            break;
+        }
+
+        recycle(b);
+        m_free.push_back(std::move(b));
+        m_batches.erase(m_batches.begin());
+    }
+}
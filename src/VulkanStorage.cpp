@@ -0,0 +1,8 @@
+// One-definition home for the header only libraries, so that main and atom_bench can share
+// every other translation unit through the atom library.
+#define VMA_IMPLEMENTATION
+#include "vk_mem_alloc.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
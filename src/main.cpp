@@ -1,6 +1,3 @@
-#define VMA_IMPLEMENTATION
-#include "vk_mem_alloc.hpp"
-
 #if defined(WIN32) && defined(_DEBUG)
 #include <Windows.h>
 
@@ -8,8 +5,12 @@ const HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
 #endif
 
 #include "App.hpp"
+#include "CommandLine.hpp"
+#include "Trace.hpp"
+
+#include <cstring>
 
-int main() {
+int main(int argc, char** argv) {
 #if defined(WIN32) && defined(_DEBUG)
     DWORD currentConfig;
     GetConsoleMode(console, &currentConfig);
@@ -19,13 +20,97 @@ int main() {
                                 currentConfig);
 #endif
 
+    AppSettings settings;
+    uint32_t headlessFrames = 1;
+    std::string outPath;
+    std::string tracePath;
+    std::string sceneName = "main";
+    VertexFormat vertexFormat = VertexFormat::Float32;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            settings.headless = true;
+        } else if (strcmp(argv[i], "--no-culling") == 0) {
+            settings.gpuCulling = false;
+        } else if (strcmp(argv[i], "--lod-threshold") == 0 && i + 1 < argc && parseArgument(argv[i + 1], settings.lodThresholdPixels)) {
+            i++;
+        } else if (strcmp(argv[i], "--vertex-format") == 0 && i + 1 < argc && vertexFormatFromName(argv[i + 1], vertexFormat)) {
+            i++;
+        } else if (strcmp(argv[i], "--vertex-pulling") == 0) {
+            settings.vertexPulling = true;
+        } else if (strcmp(argv[i], "--record-threads") == 0 && i + 1 < argc && parseArgument(argv[i + 1], settings.recordThreads)) {
+            i++;
+        } else if (strcmp(argv[i], "--pipeline-cache") == 0 && i + 1 < argc) {
+            settings.pipelineCachePath = argv[++i];
+        } else if (strcmp(argv[i], "--no-pipeline-cache") == 0) {
+            settings.pipelineCachePath.clear();
+        } else if (strcmp(argv[i], "--shader-dir") == 0 && i + 1 < argc) {
+            settings.shaderDir = argv[++i];
+        } else if (strcmp(argv[i], "--no-hot-reload") == 0) {
+            settings.shaderHotReload = false;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc && parseArgument(argv[i + 1], headlessFrames)) {
+            i++;
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc && parseArgument(argv[i + 1], settings.width)) {
+            i++;
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc && parseArgument(argv[i + 1], settings.height)) {
+            i++;
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            sceneName = argv[++i];
+        } else {
+            std::cerr << "Unknown argument or invalid value: " << argv[i] << "\n";
+            std::cerr << "Usage: main [--headless] [--no-culling] [--lod-threshold px] [--vertex-format float|half|snorm16] [--vertex-pulling] [--record-threads N] [--pipeline-cache file | --no-pipeline-cache] [--shader-dir dir] [--no-hot-reload] [--frames N] [--width W] [--height H] [--out frame.ppm] [--scene name] [--trace trace.json]\n";
+            return -1;
+        }
+    }
+
+    // Zones cost next to nothing but aren't free, only record when there's somewhere to write them
+    Trace::setEnabled(!tracePath.empty());
+
+    auto scene = createScene(sceneName);
+
+    if (!scene) {
+        std::cerr << "Unknown scene: " << sceneName << "\n";
+        return -1;
+    }
+
+    scene->vertexFormat = vertexFormat;
+
     App app;
+    app.setScene(std::move(scene));
 
-    if (!app.init()) {
-        system("PAUSE");
+    if (!app.init(settings)) {
+        if (!settings.headless) {
+            system("PAUSE");
+        }
         return -1;
     }
+
+    if (settings.headless) {
+        bool ok = app.runHeadless(headlessFrames);
+
+        if (ok && !outPath.empty()) {
+            ok = app.saveFrame(outPath);
+        }
+
+        if (!tracePath.empty()) {
+            Trace::dumpChromeJson(tracePath);
+        }
+
+        app.destroy();
+
+        return ok ? 0 : -1;
+    }
+
     app.windowLoop();
+
+    if (!tracePath.empty()) {
+        Trace::dumpChromeJson(tracePath);
+    }
+
     app.destroy();
 
     return 0;
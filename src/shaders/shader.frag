@@ -1,9 +1,37 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragMaterial;
 
 layout(location = 0) out vec4 outColor;
 
+struct Material {
+    vec4 baseColor;
+    uint textureIndex;  // Bindless slots
+    uint samplerIndex;
+    uint pad0;
+    uint pad1;
+};
+
+// Bindless set (Bindless.hpp), everything is picked by index
+layout(set = 1, binding = 0) uniform texture2D textures[];
+layout(set = 1, binding = 1) uniform sampler samplers[];
+
+layout(std430, set = 1, binding = 2) readonly buffer Materials {
+    Material materials[];
+} materialBuffers[];
+
+layout(push_constant) uniform Push {
+    uint materialBuffer;  // Storage buffer slot of the scene's materials
+} pc;
+
 void main() {
-    outColor = vec4(fragColor, 1.0);
-}
\ No newline at end of file
+    // Instances of one draw can use different materials
+    Material material = materialBuffers[pc.materialBuffer].materials[fragMaterial];
+
+    vec4 texel = texture(sampler2D(textures[nonuniformEXT(material.textureIndex)], samplers[nonuniformEXT(material.samplerIndex)]), fragTexCoord);
+
+    outColor = vec4(fragColor * material.baseColor.rgb * texel.rgb, 1.0);
+}
@@ -1,18 +1,31 @@
 #version 450
 
+// Float or compact (PackedVertex) vertices, the attribute formats convert either one. Compact positions are
+// normalized to the mesh bounds, inModel already contains the dequantization. The inputs are mirrored by hand in
+// SceneVertexShaderInputs (Vertex.hpp), update it along with them.
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
-// layout(binding = 0) uniform UBO {
-//     mat4 model,
-//     mat4 view,
-//     mat4 projection
-// } ubo;
+// Per instance, written by the culling pass
+layout(location = 3) in mat4 inModel;  // Takes locations 3 - 6
+layout(location = 7) in vec4 inInstanceColor;
+layout(location = 8) in uint inMaterial;
+
+// Frame allocator, dynamic offset per frame (CameraUbo)
+layout(set = 0, binding = 0) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+} camera;
 
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragMaterial;
 
 void main() {
-    gl_Position = vec4(inPosition, 1.0);
-    fragColor = inColor;
-}
\ No newline at end of file
+    gl_Position = camera.viewProjection * inModel * vec4(inPosition, 1.0);
+    fragColor = inColor * inInstanceColor.rgb;
+    fragTexCoord = inTexCoord;
+    fragMaterial = inMaterial;
+}
@@ -0,0 +1,83 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+
+// Vertex pulling variant of shader.vert: no vertex input state, vertices and instances are read straight from the
+// scene's buffers through their device addresses. The vertex format is a specialization constant, the pipeline only
+// contains the decode it needs.
+
+#define VERTEX_FORMAT_FLOAT32 0  // VertexFormat, Vertex.hpp
+#define VERTEX_FORMAT_HALF 1
+#define VERTEX_FORMAT_SNORM16 2
+
+layout(constant_id = 0) const uint VERTEX_FORMAT = VERTEX_FORMAT_FLOAT32;  // SPEC_VERTEX_FORMAT
+
+struct VisibleInstance {
+    mat4 transform;
+    vec4 color;
+    uint material;
+};
+
+// Vertex (8 words) or PackedVertex (4 words)
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer VertexWords {
+    uint words[];
+};
+
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer Instances {
+    VisibleInstance instances[];
+};
+
+// ScenePushConstants
+layout(push_constant) uniform Push {
+    uint materialBuffer;
+    uint pad;
+    VertexWords vertices;
+    Instances instances;
+} pc;
+
+// Frame allocator, dynamic offset per frame (CameraUbo)
+layout(set = 0, binding = 0) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+} camera;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragMaterial;
+
+void main() {
+    // Indexed draws already add vertexOffset and firstInstance
+    vec3 position;
+    vec3 color;
+    vec2 texCoord;
+
+    if (VERTEX_FORMAT == VERTEX_FORMAT_FLOAT32) {
+        uint base = uint(gl_VertexIndex) * 8;
+
+        position = uintBitsToFloat(uvec3(pc.vertices.words[base], pc.vertices.words[base + 1], pc.vertices.words[base + 2]));
+        color = uintBitsToFloat(uvec3(pc.vertices.words[base + 3], pc.vertices.words[base + 4], pc.vertices.words[base + 5]));
+        texCoord = uintBitsToFloat(uvec2(pc.vertices.words[base + 6], pc.vertices.words[base + 7]));
+    } else {
+        uint base = uint(gl_VertexIndex) * 4;
+
+        // Normalized to the mesh bounds, the instance transform contains the dequantization
+        uint xy = pc.vertices.words[base];
+        uint zw = pc.vertices.words[base + 1];
+
+        if (VERTEX_FORMAT == VERTEX_FORMAT_HALF) {
+            position = vec3(unpackHalf2x16(xy), unpackHalf2x16(zw).x);
+        } else {
+            position = vec3(unpackSnorm2x16(xy), unpackSnorm2x16(zw).x);
+        }
+
+        color = unpackUnorm4x8(pc.vertices.words[base + 2]).rgb;
+        texCoord = unpackHalf2x16(pc.vertices.words[base + 3]);
+    }
+
+    VisibleInstance inst = pc.instances.instances[gl_InstanceIndex];
+
+    gl_Position = camera.viewProjection * inst.transform * vec4(position, 1.0);
+    fragColor = color * inst.color.rgb;
+    fragTexCoord = texCoord;
+    fragMaterial = inst.material;
+}